@@ -11,8 +11,11 @@
 #include <sprocket/core/input_codes.h>
 #include <sprocket/core/log.h>
 #include <sprocket/graphics/camera.h>
+#include <sprocket/graphics/gpu_profiler.h>
 #include <sprocket/graphics/material.h>
 #include <sprocket/graphics/render_context.h>
+#include <sprocket/graphics/render_stats.h>
+#include <sprocket/graphics/texture.h>
 #include <sprocket/ui/ImGuiXtra.h>
 #include <sprocket/utility/file_browser.h>
 #include <sprocket/utility/maths.h>
@@ -20,11 +23,16 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cinttypes>
+#include <filesystem>
 #include <string_view>
 #include <ranges>
 
 namespace {
 
+constexpr std::string_view SKYBOX = "resources/Textures/Skybox/Skybox.yaml";
+
 template <typename T>
 T& get_singleton(anvil::registry& reg)
 {
@@ -58,16 +66,9 @@ app::app(spkt::window* window)
     , d_asset_manager()
     , d_entity_renderer(&d_asset_manager)
     , d_skybox_renderer()
-    , d_skybox({
-        "Resources/Textures/Skybox/Skybox_X_Pos.png",
-        "Resources/Textures/Skybox/Skybox_X_Neg.png",
-        "Resources/Textures/Skybox/Skybox_Y_Pos.png",
-        "Resources/Textures/Skybox/Skybox_Y_Neg.png",
-        "Resources/Textures/Skybox/Skybox_Z_Pos.png",
-        "Resources/Textures/Skybox/Skybox_Z_Neg.png"
-    })
     , d_editor_camera(d_window, {0.0, 0.0, 0.0})
     , d_viewport(1280, 720)
+    , d_resolution(1280, 720)
     , d_ui(d_window)
 {
     d_window->set_cursor_visibility(true);
@@ -135,9 +136,11 @@ void app::on_render()
     // the framebuffer.
     if (d_viewport_size != d_viewport.size() && d_viewport_size.x > 0 && d_viewport_size.y > 0) {
         d_viewport.resize(d_viewport_size.x, d_viewport_size.y);
+        d_resolution.set_output_size(d_viewport_size.x, d_viewport_size.y);
     }
 
     d_viewport.bind();
+    d_resolution.begin_frame();
 
     const auto [proj, view] = std::invoke([&] {
         if (d_playing_game) {
@@ -147,12 +150,13 @@ void app::on_render()
     });
 
     anvil::draw_scene(d_entity_renderer, registry, proj, view);
-    d_skybox_renderer.draw(d_skybox, proj, view);
+    d_skybox_renderer.draw(d_asset_manager.get<spkt::cube_map>(SKYBOX), proj, view);
 
     if (d_show_colliders) {
         anvil::draw_colliders(d_collider_renderer, registry, proj, view);
     }
 
+    d_resolution.end_frame();
     d_viewport.unbind();
 
     d_ui.start_frame();
@@ -370,6 +374,68 @@ void app::on_render()
         ImGui::End();
     }
 
+    if (ImGui::Begin("GPU Profiler")) {
+        auto& profiler = spkt::gpu_profiler::get();
+        bool enabled = profiler.is_enabled();
+        if (ImGui::Checkbox("Enabled", &enabled)) {
+            profiler.set_enabled(enabled);
+        }
+
+        ImGui::Text("Results lag by %zu frames", spkt::gpu_profiler::FRAME_LAG - 1);
+        for (const auto& timing : profiler.results()) {
+            ImGui::Text("%*s%s: %.3f ms", (int)(2 * timing.depth), "", timing.name.c_str(), timing.milliseconds);
+        }
+
+        ImGui::Separator();
+        const auto& stats = spkt::last_frame_render_stats();
+        ImGui::Text("Draw calls: %" PRIu64 " (%" PRIu64 " instanced)", stats.draw_calls, stats.instanced_draws);
+        ImGui::Text("Instances: %" PRIu64, stats.instances);
+        ImGui::Text("Triangles: %" PRIu64, stats.triangles);
+        ImGui::Text("Shader binds: %" PRIu64, stats.shader_binds);
+        ImGui::Text("Texture binds: %" PRIu64, stats.texture_binds);
+        ImGui::Text("Uniform uploads: %" PRIu64, stats.uniform_uploads);
+        ImGui::Text("Buffer bytes: %" PRIu64, stats.buffer_bytes);
+        ImGui::Text("Texture memory: %.2f MiB", spkt::texture::total_memory() / (1024.0 * 1024.0));
+
+        if (ImGui::CollapsingHeader("Dynamic Resolution")) {
+            bool dynamic = d_resolution.is_enabled();
+            if (ImGui::Checkbox("Dynamic", &dynamic)) {
+                d_resolution.set_enabled(dynamic);
+            }
+            float target = d_resolution.target_frame_time();
+            if (ImGui::SliderFloat("Target (ms)", &target, 1.0f, 33.0f)) {
+                d_resolution.set_target_frame_time(target);
+            }
+            float bounds[2] = {d_resolution.min_scale(), d_resolution.max_scale()};
+            if (ImGui::SliderFloat2("Scale bounds", bounds, 0.25f, 1.0f)) {
+                d_resolution.set_scale_bounds(bounds[0], bounds[1]);
+            }
+            float sharpness = d_resolution.sharpness();
+            if (ImGui::SliderFloat("Sharpness", &sharpness, 0.0f, 1.0f)) {
+                d_resolution.set_sharpness(sharpness);
+            }
+            const auto size = d_resolution.render_size();
+            ImGui::Text("Scale %.2f (%dx%d), scene %.2f ms", d_resolution.scale(), size.x, size.y, d_resolution.gpu_time());
+        }
+
+        auto& streamer = d_entity_renderer.texture_streaming();
+        if (ImGui::CollapsingHeader("Texture Streaming")) {
+            ImGui::Text("Budget: %.2f MiB", streamer.memory_budget() / (1024.0 * 1024.0));
+            ImGui::Text("Streamed: %zu (%zu reading)", streamer.streamed_count(), streamer.pending_count());
+            for (const auto& [file, tex] : d_asset_manager.view<spkt::texture>()) {
+                if (!tex.is_streamed()) { continue; }
+                const int level = tex.resident_level();
+                ImGui::Text("%s: mip %d/%d (%dx%d, %.2f MiB)",
+                            std::filesystem::path(file).filename().string().c_str(),
+                            level, tex.mip_levels() - 1,
+                            std::max(tex.width() >> level, 1), std::max(tex.height() >> level, 1),
+                            tex.memory() / (1024.0 * 1024.0));
+            }
+        }
+
+        ImGui::End();
+    }
+
     d_ui.end_frame();
 }
 
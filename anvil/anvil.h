@@ -7,8 +7,9 @@
 #include <sprocket/core/events.h>
 #include <sprocket/core/window.h>
 #include <sprocket/graphics/asset_manager.h>
-#include <sprocket/graphics/cube_map.h>
+#include <sprocket/graphics/dynamic_resolution.h>
 #include <sprocket/graphics/frame_buffer.h>
+#include <sprocket/graphics/pixel_buffer.h>
 #include <sprocket/graphics/renderers/geometry_renderer.h>
 #include <sprocket/graphics/renderers/pbr_renderer.h>
 #include <sprocket/graphics/renderers/skybox_renderer.h>
@@ -22,7 +23,9 @@ namespace anvil {
 class app
 {
     spkt::window*       d_window;
-    spkt::asset_manager d_asset_manager;
+
+    spkt::pixel_unpack_pool d_pixel_pool;
+    spkt::asset_manager     d_asset_manager;
     
     camera d_editor_camera;
 
@@ -34,18 +37,21 @@ class app
     spkt::frame_buffer d_viewport;
     glm::ivec2 d_viewport_size;
 
+    // The scene is rendered at a resolution that holds the frame time, then upscaled
+    // into the viewport.
+    spkt::dynamic_resolution d_resolution;
+
     spkt::imgui_ui d_ui;
     bool d_is_viewport_hovered = false;
     bool d_is_viewport_focused = false;
 
     // Scene
-    std::string d_sceneFile = "Resources/Anvil.yaml";
+    std::string d_sceneFile = "resources/Anvil.yaml";
     std::shared_ptr<anvil::scene> d_active_scene;
     std::shared_ptr<anvil::scene> d_scene;
     anvil::entity d_runtime_camera;
 
     // Additional world setup
-    spkt::cube_map d_skybox;
     float  d_sun_angle = 45.0f;
     
     // LAYER DATA
@@ -0,0 +1,283 @@
+// Renders a scene offscreen along a scripted camera path and reports frame time statistics
+// along with a checksum of the final frame, so that rendering changes can be compared for
+// both speed and output. Intended to be run with the headless window backend, from a
+// build configured with -DSPROCKET_HEADLESS=ON.
+//
+// With --dynamic-resolution, the scene is drawn through spkt::dynamic_resolution aiming
+// for the given GPU time, and the scale it settles on is reported as the run goes.
+//
+// Usage: sprocket_bench [--gpu-particles] [--no-packing] [--dynamic-resolution=<ms>] <scene.yaml> [frames=300] [width=1280 height=720]
+#include <anvil/ecs/ecs.h>
+#include <anvil/ecs/loader.h>
+#include <anvil/particle_system.h>
+#include <anvil/rendering.h>
+#include <anvil/scene_utils.h>
+
+#include <sprocket/core/log.h>
+#include <sprocket/core/window.h>
+#include <sprocket/graphics/asset_manager.h>
+#include <sprocket/graphics/cube_map.h>
+#include <sprocket/graphics/dynamic_resolution.h>
+#include <sprocket/graphics/gpu_profiler.h>
+#include <sprocket/graphics/open_gl.h>
+#include <sprocket/graphics/pixel_buffer.h>
+#include <sprocket/graphics/render_stats.h>
+#include <sprocket/graphics/renderers/pbr_renderer.h>
+#include <sprocket/graphics/renderers/skybox_renderer.h>
+#include <sprocket/graphics/texture.h>
+#include <sprocket/utility/hashing.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr std::string_view SKYBOX = "resources/Textures/Skybox/Skybox.yaml";
+
+// Frames rendered once all assets have loaded but before measuring, so that shader
+// variants and caches are warm.
+constexpr std::size_t WARMUP_FRAMES = 10;
+
+// Particles are stepped with a fixed time step so every run simulates the same amount.
+constexpr double TIME_STEP = 1.0 / 60.0;
+
+struct frame_time_stats
+{
+    double min;
+    double mean;
+    double median;
+    double p95;
+    double max;
+};
+
+frame_time_stats summarise(std::vector<double> samples)
+{
+    if (samples.empty()) {
+        return {0.0, 0.0, 0.0, 0.0, 0.0};
+    }
+    std::ranges::sort(samples);
+    const auto percentile = [&](double p) {
+        return samples[(std::size_t)(p * (samples.size() - 1))];
+    };
+    return {
+        .min = samples.front(),
+        .mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size(),
+        .median = percentile(0.5),
+        .p95 = percentile(0.95),
+        .max = samples.back()
+    };
+}
+
+void print_stats(std::string_view name, const frame_time_stats& stats)
+{
+    std::cout << std::format("{:<4} ms: min {:8.3f}  mean {:8.3f}  median {:8.3f}  p95 {:8.3f}  max {:8.3f}\n",
+                             name, stats.min, stats.mean, stats.median, stats.p95, stats.max);
+}
+
+// One full orbit of the camera about the vertical axis over the run, keeping its
+// starting distance from the axis and its height.
+void move_camera(anvil::Transform3DComponent& transform, const glm::vec3& start, float t)
+{
+    const float radius = std::max(glm::length(glm::vec2{start.x, start.z}), 1.0f);
+    const float angle = glm::two_pi<float>() * t;
+    transform.position = {radius * glm::sin(angle), start.y, radius * glm::cos(angle)};
+
+    // The camera looks down -z; face the axis, leaving the pitch to the camera component.
+    transform.orientation = glm::angleAxis(angle, glm::vec3{0.0f, 1.0f, 0.0f});
+}
+
+// The most memory the process has had resident at once, in bytes.
+std::size_t peak_resident_memory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (std::size_t)usage.ru_maxrss;
+#else
+    return (std::size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+std::uint64_t frame_checksum(int width, int height)
+{
+    const auto pixels = spkt::read_pixels(width, height);
+    return spkt::fnv1a({reinterpret_cast<const char*>(pixels.data()), pixels.size()});
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    bool pack_materials = true;
+    anvil::particle_backend particles = anvil::particle_backend::CPU;
+    std::optional<float> resolution_target;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.starts_with("--dynamic-resolution=")) {
+            resolution_target = std::stof(arg.substr(arg.find('=') + 1));
+        } else if (arg == "--gpu-particles") {
+            particles = anvil::particle_backend::GPU;
+        } else if (arg == "--no-packing") {
+            pack_materials = false;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty()) {
+        std::cout << std::format("usage: {} [--gpu-particles] [--no-packing] [--dynamic-resolution=<ms>] <scene.yaml> [frames=300] [width=1280 height=720]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string scene_file = args[0];
+    const std::size_t frames = args.size() > 1 ? std::max(std::stoull(args[1]), 1ull) : 300;
+    const std::uint32_t width = args.size() > 3 ? std::stoul(args[2]) : 1280;
+    const std::uint32_t height = args.size() > 3 ? std::stoul(args[3]) : 720;
+
+    spkt::window window{"Sprocket Bench", width, height};
+    spkt::pixel_unpack_pool pixel_pool;
+    spkt::asset_manager asset_manager;
+    spkt::pbr_renderer scene_renderer{&asset_manager};
+    scene_renderer.set_material_packing(pack_materials);
+    spkt::skybox_renderer skybox_renderer;
+
+    std::optional<spkt::dynamic_resolution> resolution;
+    if (resolution_target) {
+        resolution.emplace(width, height);
+        resolution->set_target_frame_time(*resolution_target);
+    }
+
+    anvil::registry registry;
+    anvil::load_registry_from_file(scene_file, registry);
+    anvil::set_particle_backend(registry, particles);
+
+    const anvil::entity camera = registry.find<anvil::Camera3DComponent>();
+    if (!registry.valid(camera) || !registry.has<anvil::Transform3DComponent>(camera)) {
+        spkt::log::fatal("Scene {} has no camera", scene_file);
+        return 1;
+    }
+    auto& camera_transform = registry.get<anvil::Transform3DComponent>(camera);
+    const glm::vec3 camera_start = camera_transform.position;
+
+    const auto render = [&] {
+        anvil::particle_system(registry, TIME_STEP);
+        window.begin_frame();
+        spkt::gpu_profiler::get().begin_frame();
+        {
+            spkt::gpu_scope scope{"frame"};
+            if (resolution) { resolution->begin_frame(); }
+            auto [proj, view] = anvil::get_proj_view_matrices(registry, camera);
+            skybox_renderer.draw(asset_manager.get<spkt::cube_map>(SKYBOX), proj, view);
+            anvil::draw_scene(scene_renderer, registry, proj, view);
+            if (resolution) { resolution->end_frame(); }
+        }
+        spkt::end_render_stats_frame();
+        pixel_pool.collect();
+        window.end_frame();
+    };
+
+    // Assets load asynchronously, so render until everything has arrived, otherwise the
+    // first frames would measure an empty scene.
+    std::size_t loading_frames = 0;
+    const auto load_start = std::chrono::steady_clock::now();
+    do {
+        render();
+        ++loading_frames;
+    } while (asset_manager.is_loading_anything());
+    const auto load_end = std::chrono::steady_clock::now();
+    const double load_time = std::chrono::duration<double, std::milli>(load_end - load_start).count();
+    spkt::log::info("Assets loaded after {} frames", loading_frames);
+
+    spkt::gpu_profiler::get().set_enabled(true);
+    for (std::size_t i = 0; i != WARMUP_FRAMES; ++i) {
+        render();
+    }
+
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+    std::vector<std::pair<float, float>> scales; // Scale and smoothed scene time per frame
+    cpu_times.reserve(frames);
+    gpu_times.reserve(frames);
+
+    // GPU timings are read back gpu_profiler::FRAME_LAG frames late, so keep rendering
+    // the final frame until all of the measured frames have been collected. A frame whose
+    // queries were not ready is skipped by the profiler, leaving the previous results in
+    // place, so timings are only recorded when a new frame has been collected.
+    auto& profiler = spkt::gpu_profiler::get();
+    std::size_t frames_collected = profiler.frames_collected();
+    for (std::size_t i = 0; i != frames + spkt::gpu_profiler::FRAME_LAG; ++i) {
+        const float t = (float)std::min(i, frames - 1) / (float)frames;
+        move_camera(camera_transform, camera_start, t);
+
+        const auto start = std::chrono::steady_clock::now();
+        render();
+        const auto end = std::chrono::steady_clock::now();
+
+        if (i < frames) {
+            cpu_times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            if (resolution) { scales.emplace_back(resolution->scale(), resolution->gpu_time()); }
+        }
+        const bool collected = profiler.frames_collected() != frames_collected;
+        frames_collected = profiler.frames_collected();
+        if (i >= spkt::gpu_profiler::FRAME_LAG && collected) {
+            for (const auto& timing : profiler.results()) {
+                if (timing.depth == 0 && timing.name == "frame") {
+                    gpu_times.push_back(timing.milliseconds);
+                }
+            }
+        }
+    }
+
+    const std::uint64_t checksum = frame_checksum(width, height);
+    const auto& stats = spkt::last_frame_render_stats();
+
+    std::cout << std::format("scene: {} ({}x{}, {} frames)\n", scene_file, width, height, frames);
+    print_stats("cpu", summarise(cpu_times));
+    print_stats("gpu", summarise(gpu_times));
+    if (gpu_times.size() != frames) {
+        std::cout << std::format("gpu timings collected for {} of {} frames\n", gpu_times.size(), frames);
+    }
+    if (resolution) {
+        std::cout << std::format("dynamic resolution, target {:.2f} ms:\n", resolution->target_frame_time());
+        constexpr std::size_t ROWS = 10;
+        for (std::size_t row = 0; row != ROWS; ++row) {
+            const std::size_t frame = row * (frames - 1) / (ROWS - 1);
+            const auto [scale, scene_ms] = scales[frame];
+            std::cout << std::format("  frame {:>5}: scale {:.3f}, scene {:8.3f} ms\n", frame, scale, scene_ms);
+        }
+    }
+    std::cout << std::format("draw calls: {}, triangles: {}\n", stats.draw_calls, stats.triangles);
+    std::cout << std::format("texture memory: {:.2f} MiB\n", spkt::texture::total_memory() / (1024.0 * 1024.0));
+    std::cout << std::format("asset load: {:.1f} ms ({} frames), peak RSS: {:.2f} MiB\n",
+                             load_time, loading_frames, peak_resident_memory() / (1024.0 * 1024.0));
+    std::cout << std::format("checksum: {:016x}\n", checksum);
+    return 0;
+}
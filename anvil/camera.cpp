@@ -1,4 +1,4 @@
-#include "Camera.h"
+#include "camera.h"
 
 #include <sprocket/core/events.h>
 #include <sprocket/core/input_codes.h>
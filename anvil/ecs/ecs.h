@@ -1,5 +1,6 @@
 #pragma once
 #include <apecs.hpp>
+#include <sprocket/graphics/gpu_particles.h>
 #include <sprocket/graphics/particles.h>
 #include <sprocket/scripting/lua_script.h>
 #include <sprocket/utility/hashing.h>
@@ -162,8 +163,8 @@ struct InputSingleton
 
 struct ParticleSingleton
 {
-    std::shared_ptr<std::array<spkt::particle, spkt::NUM_PARTICLES>> particles = nullptr;
-    std::size_t next_slot = spkt::NUM_PARTICLES - 1;
+    std::shared_ptr<spkt::particle_pool> particles = nullptr;
+    std::shared_ptr<spkt::gpu_particle_system> gpu_particles = nullptr;
 };
 
 using registry = apx::registry<
@@ -535,15 +535,15 @@ struct reflcomp<ParticleSingleton>
     template <typename Func>
     void for_each_attribute(ParticleSingleton& component, Func&& func)
     {
-        func(reflattr<std::shared_ptr<std::array<spkt::particle, spkt::NUM_PARTICLES>>, true, true>{.name="particles", .display_name="Particles", .value=&component.particles, .metadata={} });
-        func(reflattr<std::size_t, true, true>{.name="next_slot", .display_name="Next Slot", .value=&component.next_slot, .metadata={} });
+        func(reflattr<std::shared_ptr<spkt::particle_pool>, true, true>{.name="particles", .display_name="Particles", .value=&component.particles, .metadata={} });
+        func(reflattr<std::shared_ptr<spkt::gpu_particle_system>, true, true>{.name="gpu_particles", .display_name="GPU Particles", .value=&component.gpu_particles, .metadata={} });
     }
 
     template <typename Func>
     void for_each_attribute(const ParticleSingleton& component, Func&& func) const
     {
-        func(reflattr<const std::shared_ptr<std::array<spkt::particle, spkt::NUM_PARTICLES>>, true, true>{.name="particles", .display_name="Particles", .value=&component.particles, .metadata={} });
-        func(reflattr<const std::size_t, true, true>{.name="next_slot", .display_name="Next Slot", .value=&component.next_slot, .metadata={} });
+        func(reflattr<const std::shared_ptr<spkt::particle_pool>, true, true>{.name="particles", .display_name="Particles", .value=&component.particles, .metadata={} });
+        func(reflattr<const std::shared_ptr<spkt::gpu_particle_system>, true, true>{.name="gpu_particles", .display_name="GPU Particles", .value=&component.gpu_particles, .metadata={} });
     }
 };
 
@@ -0,0 +1,80 @@
+// Measures how anvil::gather_static_meshes scales with the number of threads, by running
+// it on job pools of 0 up to max_workers workers, plus the calling thread. The registry
+// holds the given number of entities spread over 10 meshes and 8 materials.
+//
+// Usage: gather_bench [entities=100000] [frames=100] [max_workers=hardware threads - 1]
+#include <anvil/ecs/ecs.h>
+#include <anvil/rendering.h>
+
+#include <sprocket/utility/parallel.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t NUM_MESHES = 10;
+constexpr std::size_t NUM_MATERIALS = 8;
+
+double time_gathers(
+    const anvil::registry& registry, std::size_t entities, spkt::job_pool& pool, std::size_t frames)
+{
+    std::size_t instances = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != frames; ++i) {
+        for (const auto& bucket : anvil::gather_static_meshes(registry, pool)) {
+            for (const auto& [key, models] : bucket.commands) {
+                instances += models.size();
+            }
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    if (instances != frames * entities) {
+        std::cout << std::format("unexpected instance count {} (expected {})\n", instances, frames * entities);
+    }
+    return std::chrono::duration<double, std::milli>(end - start).count() / frames;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t entities = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    const std::size_t frames = std::max(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100ull, 1ull);
+    const std::size_t max_workers = argc > 3
+        ? std::strtoull(argv[3], nullptr, 10)
+        : std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    anvil::registry registry;
+    for (std::size_t i = 0; i != entities; ++i) {
+        const auto entity = registry.create();
+        registry.add<anvil::StaticModelComponent>(entity, {
+            .mesh = std::format("resources/Models/Mesh{}.obj", i % NUM_MESHES),
+            .material = std::format("resources/Materials/Material{}.yaml", i % NUM_MATERIALS)
+        });
+        registry.add<anvil::Transform3DComponent>(entity, {
+            .position = {(float)i, 0.0f, 0.0f}
+        });
+    }
+
+    std::cout << std::format("{} entities, {} hardware threads\n", entities, std::thread::hardware_concurrency());
+    std::cout << std::format("{:>8} {:>12} {:>10}\n", "threads", "ms/frame", "speedup");
+    double single = 0.0;
+    for (std::size_t workers = 0; workers <= max_workers; ++workers) {
+        spkt::job_pool pool{workers};
+        time_gathers(registry, entities, pool, 1); // Warm up the workers and the allocator
+        const double ms = time_gathers(registry, entities, pool, frames);
+        if (workers == 0) { single = ms; }
+        std::cout << std::format("{:>8} {:>12.3f} {:>9.2f}x\n", workers + 1, ms, single / ms);
+    }
+    return 0;
+}
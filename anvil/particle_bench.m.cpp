@@ -0,0 +1,66 @@
+// Measures the cost of spkt::particle_pool::update for a range of live particle counts at
+// a fixed capacity, and for a fixed live count at a range of capacities. The cost should
+// scale with the number of live particles and be independent of the capacity.
+//
+// Usage: particle_bench [updates=1000]
+#include <sprocket/graphics/particles.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <format>
+#include <initializer_list>
+#include <iostream>
+
+namespace {
+
+// Particles live long enough to survive the whole run so the live count stays fixed.
+constexpr float LIFE = 1.0e9f;
+constexpr float DT = 1.0f / 60.0f;
+
+double time_updates(std::size_t capacity, std::size_t live, std::size_t updates)
+{
+    spkt::particle_pool pool{capacity};
+    for (std::size_t i = 0; i != live; ++i) {
+        pool.emit({
+            .position = {(float)i, 0.0f, 0.0f},
+            .velocity = {0.0f, 1.0f, 0.0f},
+            .acceleration = {0.0f, -9.81f, 0.0f},
+            .life = LIFE
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != updates; ++i) {
+        pool.update(DT);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    if (pool.size() != live) {
+        std::cout << std::format("unexpected live count {} (expected {})\n", pool.size(), live);
+    }
+    return std::chrono::duration<double, std::micro>(end - start).count() / updates;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t updates = std::max(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000ull, 1ull);
+
+    std::cout << std::format("{:>10} {:>10} {:>12} {:>14}\n", "capacity", "live", "us/update", "ns/particle");
+    const auto report = [&](std::size_t capacity, std::size_t live) {
+        const double us = time_updates(capacity, live, updates);
+        const double ns_per_particle = live > 0 ? 1000.0 * us / live : 0.0;
+        std::cout << std::format("{:>10} {:>10} {:>12.3f} {:>14.3f}\n", capacity, live, us, ns_per_particle);
+    };
+
+    for (std::size_t live : {0, 100, 1000, 10000, 100000, 1000000}) {
+        report(1000000, live);
+    }
+    for (std::size_t capacity : {1000, 10000, 100000, 1000000}) {
+        report(capacity, 1000);
+    }
+    return 0;
+}
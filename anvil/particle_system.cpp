@@ -5,7 +5,6 @@
 
 #include <glm/glm.hpp>
 
-#include <array>
 #include <memory>
 
 namespace anvil {
@@ -19,7 +18,7 @@ anvil::ParticleSingleton& get_particle_runtime(anvil::registry& registry)
         registry.emplace<anvil::Runtime>(entity);
         registry.emplace<anvil::NameComponent>(entity, "::ParticleRuntimeSingleton");
         auto& ps = registry.emplace<anvil::ParticleSingleton>(entity);
-        ps.particles = std::make_shared<std::array<spkt::particle, spkt::NUM_PARTICLES>>();
+        ps.particles = std::make_shared<spkt::particle_pool>();
     }
     return registry.get<anvil::ParticleSingleton>(entity);
 }
@@ -39,31 +38,52 @@ glm::vec3 random_noise(float R)
 
 }
 
+void set_particle_backend(anvil::registry& registry, particle_backend backend)
+{
+    auto& ps = get_particle_runtime(registry);
+    if ((backend == particle_backend::GPU) == (ps.gpu_particles != nullptr)) {
+        return;
+    }
+
+    ps.particles = std::make_shared<spkt::particle_pool>();
+    ps.gpu_particles = nullptr;
+    if (backend == particle_backend::GPU) {
+        ps.gpu_particles = std::make_shared<spkt::gpu_particle_system>();
+        if (!ps.gpu_particles->is_valid()) {
+            ps.gpu_particles = nullptr;
+        }
+    }
+}
+
 void particle_system(anvil::registry& registry, double dt)
 {
     auto& ps = get_particle_runtime(registry);
 
-    // Update the positions of all existing particles
-    for (auto& particle : *ps.particles) {
-        particle.life -= dt;
-        particle.position += particle.velocity * (float)dt;
-        particle.velocity += particle.acceleration * (float)dt;
+    // Update the positions of all existing particles and remove any that have died
+    if (ps.gpu_particles) {
+        ps.gpu_particles->update((float)dt);
+    } else {
+        ps.particles->update((float)dt);
     }
 
     // Go through all particle emitter entities and check to see if they need to emit
-    // any particles this frame. If they do, add them to the particle array.
+    // any particles this frame. If they do, add them to the particle pool.
     for (auto [pc, tc] : registry.view_get<anvil::ParticleComponent, anvil::Transform3DComponent>()) {
         pc.accumulator += (float)dt;
         while (pc.accumulator > pc.interval) {
-            // Add a particle to the particle array
-            (*ps.particles)[ps.next_slot] = {
+            // Add a particle to the pool, if the pool is full it is dropped
+            const spkt::particle particle = {
                 .position = tc.position,
                 .velocity = pc.velocity + random_noise(pc.velocityNoise),
                 .acceleration = pc.acceleration,
                 .scale = pc.scale,
                 .life = pc.life
             };
-            ps.next_slot = --ps.next_slot % spkt::NUM_PARTICLES;
+            if (ps.gpu_particles) {
+                ps.gpu_particles->emit(particle);
+            } else {
+                ps.particles->emit(particle);
+            }
 
             pc.accumulator -= pc.interval;
         }
@@ -3,6 +3,17 @@
 
 namespace anvil {
 
+enum class particle_backend
+{
+    CPU, // Simulated with spkt::particle_pool and uploaded each frame
+    GPU  // Simulated with spkt::gpu_particle_system, falling back to CPU if unsupported
+};
+
+// Selects the backend that particle_system uses for the registry, creating its particle
+// runtime if needed. Particles alive in the previous backend are dropped. Registries use
+// the CPU backend until this is called.
+void set_particle_backend(anvil::registry& registry, particle_backend backend);
+
 void particle_system(anvil::registry& registry, double dt);
 
 }
\ No newline at end of file
@@ -5,12 +5,62 @@
 #include <sprocket/graphics/renderers/pbr_renderer.h>
 #include <sprocket/graphics/render_context.h>
 #include <sprocket/utility/maths.h>
+#include <sprocket/utility/parallel.h>
 #include <sprocket/utility/views.h>
 
 #include <glm/glm.hpp>
 
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
 namespace anvil {
-    
+namespace {
+
+// Below this many entities per chunk, the cost of handing the work to a worker outweighs
+// the work of packing the instances.
+constexpr std::size_t MIN_STATIC_MESHES_PER_THREAD = 2048;
+
+void submit_static_meshes(spkt::pbr_renderer& renderer, const anvil::registry& registry)
+{
+    for (auto& bucket : gather_static_meshes(registry)) {
+        renderer.submit(std::move(bucket));
+    }
+}
+
+}
+
+std::vector<spkt::static_mesh_bucket> gather_static_meshes(
+    const anvil::registry& registry, spkt::job_pool& pool)
+{
+    // The view can only be walked forwards, so the entities are copied out once and each
+    // chunk takes its own slice by index, looking up the components and packing the
+    // instances itself.
+    std::vector<anvil::entity> entities;
+    for (auto entity : registry.view<anvil::StaticModelComponent>()) {
+        entities.push_back(entity);
+    }
+
+    return spkt::parallel_for_chunks(
+        pool,
+        entities.size(),
+        MIN_STATIC_MESHES_PER_THREAD,
+        [&](std::size_t begin, std::size_t end) {
+            spkt::static_mesh_bucket bucket;
+            for (const auto entity : std::span{entities}.subspan(begin, end - begin)) {
+                if (!registry.has<anvil::Transform3DComponent>(entity)) {
+                    continue;
+                }
+                const auto& mc = registry.get<anvil::StaticModelComponent>(entity);
+                const auto& tc = registry.get<anvil::Transform3DComponent>(entity);
+                bucket.add(tc.position, tc.orientation, tc.scale, mc.mesh, mc.material);
+            }
+            return bucket;
+        }
+    );
+}
+
 void draw_colliders(
     const spkt::geometry_renderer& renderer,
     const anvil::registry& registry,
@@ -68,12 +118,7 @@ void draw_scene(
         renderer.add_light(tc.position, lc.colour, lc.brightness);
     }
 
-    for (auto [mc, tc] : registry.view_get<anvil::StaticModelComponent, anvil::Transform3DComponent>()) {
-        renderer.draw_static_mesh(
-            tc.position, tc.orientation, tc.scale,
-            mc.mesh, mc.material
-        );
-    }
+    submit_static_meshes(renderer, registry);
 
     for (auto [mc, tc] : registry.view_get<anvil::AnimatedModelComponent, anvil::Transform3DComponent>()) {
         renderer.draw_animated_mesh(
@@ -83,13 +128,13 @@ void draw_scene(
     }
 
     for (auto [ps] : registry.view_get<anvil::ParticleSingleton>()) {
-        std::vector<spkt::model_instance> instance_data(spkt::NUM_PARTICLES);
-        for (const auto& particle : *ps.particles) {
-            if (particle.life > 0.0) {
-                instance_data.push_back({particle.position, {0.0, 0.0, 0.0, 1.0}, particle.scale});
-            }
+        if (ps.gpu_particles) {
+            renderer.draw_particles(*ps.gpu_particles);
+            continue;
         }
-        renderer.draw_particles(instance_data);
+        auto region = renderer.allocate_particles(ps.particles->size());
+        const std::size_t count = ps.particles->write_instances(region.elements);
+        renderer.draw_particles(region.first, count);
     };
 
     renderer.end_frame();
@@ -3,11 +3,21 @@
 
 #include <sprocket/graphics/renderers/geometry_renderer.h>
 #include <sprocket/graphics/renderers/pbr_renderer.h>
+#include <sprocket/utility/parallel.h>
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 namespace anvil {
 
+// Packs the instances of every entity with a static model and a transform, splitting the
+// work across the pool. Used by draw_scene, and by gather_bench to measure the scaling.
+std::vector<spkt::static_mesh_bucket> gather_static_meshes(
+    const anvil::registry& registry,
+    spkt::job_pool& pool = spkt::job_pool::shared()
+);
+
 void draw_colliders(
     const spkt::geometry_renderer& renderer,
     const anvil::registry& registry,
@@ -1,4 +1,4 @@
-#include "Runtime.h"
+#include "runtime.h"
 #include <anvil/particle_system.h>
 #include <anvil/physics_system.h>
 #include <anvil/rendering.h>
@@ -14,11 +14,15 @@
 #include <sprocket/ui/console.h>
 #include <sprocket/utility/colour.h>
 
+#include <string_view>
+
 const auto LIGHT_BLUE  = spkt::from_hex(0x25CCF7);
 const auto CLEAR_BLUE  = spkt::from_hex(0x1B9CFC);
 const auto GARDEN      = spkt::from_hex(0x55E6C1);
 const auto SPACE_DARK  = spkt::from_hex(0x2C3A47);
 
+constexpr std::string_view SKYBOX = "resources/Textures/Skybox/Skybox.yaml";
+
 namespace anvil {
 
 runtime::runtime(spkt::window* window) 
@@ -41,21 +45,13 @@ runtime::runtime(spkt::window* window)
     , d_asset_manager()
     , d_scene_renderer(&d_asset_manager)
     , d_skybox_renderer()
-    , d_skybox({
-        "Resources/Textures/Skybox/Skybox_X_Pos.png",
-        "Resources/Textures/Skybox/Skybox_X_Neg.png",
-        "Resources/Textures/Skybox/Skybox_Y_Pos.png",
-        "Resources/Textures/Skybox/Skybox_Y_Neg.png",
-        "Resources/Textures/Skybox/Skybox_Z_Pos.png",
-        "Resources/Textures/Skybox/Skybox_Z_Neg.png"
-    })
     , d_ui(d_window)
     , d_console()
 {
     d_window->set_cursor_visibility(false);
 
     anvil::input_system_init(d_scene.registry, d_window);
-    anvil::load_registry_from_file("Resources/Anvil.yaml", d_scene.registry);
+    anvil::load_registry_from_file("resources/Anvil.yaml", d_scene.registry);
 
     d_runtime_camera = d_scene.registry.find<anvil::Camera3DComponent>();
 
@@ -87,13 +83,18 @@ runtime::runtime(spkt::window* window)
             console.error("Invalid args for {}", args[0]);
             return;
         }
-        const auto script_file = std::format("Resources/Scripts/{}", args[1]);
+        const auto script_file = std::format("resources/Scripts/{}", args[1]);
         if (std::filesystem::exists(script_file)) {
             spkt::lua::script script(script_file);
         } else {
             console.error(" > Could not find script '{}'", args[1]);
         }
     });
+
+    d_console.register_command("ui_stats", [&](spkt::console& console, auto args) {
+        const auto& stats = d_ui.render_stats();
+        console.log(" > {} draw calls for {} draw commands last frame", stats.draw_calls, stats.commands);
+    });
 }
 
 void runtime::on_event(spkt::event& event)
@@ -132,7 +133,7 @@ void runtime::on_update(double dt)
 void runtime::on_render()
 {
     auto [proj, view] = anvil::get_proj_view_matrices(d_scene.registry, d_runtime_camera);
-    d_skybox_renderer.draw(d_skybox, proj, view);
+    d_skybox_renderer.draw(d_asset_manager.get<spkt::cube_map>(SKYBOX), proj, view);
     anvil::draw_scene(d_scene_renderer, d_scene.registry, proj, view);
 
     if (d_console_active) {
@@ -4,7 +4,7 @@
 
 #include <sprocket/core/window.h>
 #include <sprocket/graphics/asset_manager.h>
-#include <sprocket/graphics/cube_map.h>
+#include <sprocket/graphics/pixel_buffer.h>
 #include <sprocket/graphics/renderers/pbr_renderer.h>
 #include <sprocket/graphics/renderers/skybox_renderer.h>
 #include <sprocket/ui/console.h>
@@ -17,7 +17,9 @@ namespace anvil {
 class runtime
 {
     spkt::window*       d_window;
-    spkt::asset_manager d_asset_manager;
+
+    spkt::pixel_unpack_pool d_pixel_pool;
+    spkt::asset_manager     d_asset_manager;
 
     // Rendering
     spkt::pbr_renderer    d_scene_renderer;
@@ -25,7 +27,6 @@ class runtime
 
     // Scene
     anvil::scene   d_scene;
-    spkt::cube_map d_skybox;
     
     anvil::entity d_runtime_camera;
 
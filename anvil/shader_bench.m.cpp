@@ -0,0 +1,73 @@
+// Measures how long it takes to create every shader program that the scene renderers use,
+// including all of the PBR variants, so that startup with a cold shader binary cache can
+// be compared with a warm one. Run it once after deleting .cache/shaders for the cold
+// time, and again for the warm time; the number of cached binaries found is reported.
+//
+// Usage: shader_bench [runs=1]
+#include <sprocket/core/window.h>
+#include <sprocket/graphics/asset_manager.h>
+#include <sprocket/graphics/renderers/geometry_renderer.h>
+#include <sprocket/graphics/renderers/pbr_renderer.h>
+#include <sprocket/graphics/renderers/shape_renderer.h>
+#include <sprocket/graphics/renderers/skybox_renderer.h>
+#include <sprocket/graphics/shadow_map.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+// The four material features plus the packed material flag, see pbr_renderer.
+constexpr std::uint32_t NUM_PBR_VARIANTS = 1 << 5;
+
+std::size_t cached_binaries()
+{
+    std::error_code ec;
+    const std::filesystem::directory_iterator it{".cache/shaders", ec};
+    return ec ? 0 : (std::size_t)std::distance(it, std::filesystem::directory_iterator{});
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t runs = std::max(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1ull, 1ull);
+
+    spkt::window window{"Shader Bench", 640, 480};
+    spkt::asset_manager asset_manager;
+
+    std::cout << std::format("{} cached shader binaries\n", cached_binaries());
+    std::cout << std::format("{:>4} {:>14} {:>14} {:>12}\n", "run", "renderers ms", "variants ms", "total ms");
+    for (std::size_t run = 0; run != runs; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        spkt::pbr_renderer pbr_renderer{&asset_manager};
+        spkt::skybox_renderer skybox_renderer;
+        spkt::geometry_renderer geometry_renderer;
+        spkt::shape_renderer shape_renderer;
+        spkt::shadow_map shadow_map{&asset_manager};
+        const double renderers = elapsed_ms(start);
+
+        const auto variants_start = std::chrono::steady_clock::now();
+        for (std::uint32_t features = 0; features != NUM_PBR_VARIANTS; ++features) {
+            pbr_renderer.static_shader(features);
+            pbr_renderer.animated_shader(features);
+        }
+        const double variants = elapsed_ms(variants_start);
+
+        std::cout << std::format("{:>4} {:>14.1f} {:>14.1f} {:>12.1f}\n", run + 1, renderers, variants, renderers + variants);
+    }
+    std::cout << std::format("{} cached shader binaries\n", cached_binaries());
+    return 0;
+}
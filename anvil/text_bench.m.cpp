@@ -0,0 +1,168 @@
+// Draws a panel of distinct strings at several sizes with spkt::simple_ui and reports the
+// time to the first frame, when every glyph and kerning pair is loaded from the font, and
+// the per-string cost of the frames after it. Intended to be run with the headless window
+// backend.
+//
+// The font's prebaked glyphs are restored from the cache if an earlier run left one, and
+// --cold deletes it first so that the time to rasterise them is included. Strings are laid
+// out once and reused from the font's layout cache unless --no-layout-cache is given.
+//
+// Glyph lookups are also timed on their own, for ASCII and for other codepoints.
+//
+// The strings can be spread over several panels tiling the window, for comparing the number
+// of draw calls the UI needs per frame.
+//
+// Usage: text_bench [--cold] [--no-layout-cache] [strings=3000] [frames=100] [panels=1]
+#include <sprocket/core/window.h>
+#include <sprocket/ui/simple_ui.h>
+#include <sprocket/utility/utf8.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::array<float, 4> SIZES = {12.0f, 18.0f, 24.0f, 36.0f};
+
+// Sample text for timing glyph lookups on their own.
+constexpr std::string_view ASCII_TEXT = "The quick brown fox jumps over the lazy dog 0123456789";
+constexpr std::string_view UNICODE_TEXT = "Gr\xc3\xb6\xc3\x9f" "e \xc3\xa9t\xc3\xa9 \xc3\x85ngstr\xc3\xb6m \xc3\xa6\xc3\xb8\xc3\xa5 \xc3\xbc\xc3\xb1\xc3\xae\xc3\xa7\xc3\xb8" "d\xc3\xa9";
+
+// Mixes the case, digits, punctuation and some multi-byte UTF-8 so that most kerning
+// pairs get looked up.
+std::vector<std::string> make_strings(std::size_t count)
+{
+    static constexpr std::string_view WORDS[] = {
+        "Health", "Velocity", "AVATAR", "Tower", "yaw", "Wavy", "LT", "fx", "To", "Vy",
+        "Gr\xc3\xb6\xc3\x9f" "e", "Caf\xc3\xa9"
+    };
+    std::vector<std::string> strings;
+    strings.reserve(count);
+    for (std::size_t i = 0; i != count; ++i) {
+        strings.push_back(std::format("{} {}: {:.3f}", WORDS[i % std::size(WORDS)], i, i * 0.37));
+    }
+    return strings;
+}
+
+volatile float s_sink = 0.0f; // Keeps the lookups from being optimised away
+
+// The average time to look up each codepoint of the text, in nanoseconds.
+double time_lookups(spkt::font& font, std::string_view text, std::size_t repeats)
+{
+    std::size_t lookups = 0;
+    float sink = 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != repeats; ++i) {
+        for (std::uint32_t codepoint : spkt::utf8_view(text)) {
+            sink += font.get_glyph(codepoint, SIZES[i % SIZES.size()]).advance.x;
+            ++lookups;
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    s_sink = sink;
+    return std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    bool cold = false;
+    bool layout_cache = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--cold") {
+            cold = true;
+        } else if (arg == "--no-layout-cache") {
+            layout_cache = false;
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    const std::size_t count = args.size() > 0 ? std::max(std::stoull(args[0]), 1ull) : 3000;
+    const std::size_t frames = args.size() > 1 ? std::max(std::stoull(args[1]), 1ull) : 100;
+    const std::size_t panels = args.size() > 2 ? std::max(std::stoull(args[2]), 1ull) : 1;
+
+    if (cold) {
+        std::error_code ec;
+        std::filesystem::remove_all(".cache/fonts", ec);
+    }
+
+    spkt::window window{"Text Bench", 1280, 720};
+    const auto strings = make_strings(count);
+
+    const auto start = std::chrono::steady_clock::now();
+    spkt::simple_ui ui{&window};
+    const auto constructed = std::chrono::steady_clock::now();
+    ui.get_font()->set_layout_caching(layout_cache);
+
+    const std::size_t columns = (std::size_t)std::ceil(std::sqrt((double)panels));
+    const std::size_t rows = (panels + columns - 1) / columns;
+    const glm::vec2 panel_size{1280.0f / columns, 720.0f / rows};
+    std::vector<std::string> panel_names;
+    for (std::size_t p = 0; p != panels; ++p) {
+        panel_names.push_back(std::format("Text {}", p));
+    }
+
+    const auto render = [&] {
+        window.begin_frame();
+        ui.start_frame();
+        for (std::size_t p = 0; p != panels; ++p) {
+            glm::vec4 region{(float)(p % columns) * panel_size.x, (float)(p / columns) * panel_size.y, panel_size.x, panel_size.y};
+            ui.start_panel(panel_names[p], &region, spkt::panel_type::UNCLICKABLE);
+            for (std::size_t i = p; i < strings.size(); i += panels) {
+                const float size = SIZES[i % SIZES.size()];
+                const glm::vec2 position{(float)(i % 8) * 160.0f, (float)(i / 8 % 40) * 18.0f};
+                ui.text(strings[i], size, position);
+            }
+            ui.end_panel();
+        }
+        ui.end_frame();
+        window.end_frame();
+    };
+
+    render();
+    const auto first = std::chrono::steady_clock::now();
+    ui.get_font()->reset_layout_stats();
+
+    for (std::size_t i = 0; i != frames; ++i) {
+        render();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const double construct_ms = std::chrono::duration<double, std::milli>(constructed - start).count();
+    const double first_ms = std::chrono::duration<double, std::milli>(first - start).count();
+    const double frame_ms = std::chrono::duration<double, std::milli>(end - first).count() / frames;
+
+    std::cout << std::format("{} strings at {} sizes in {} panels, {} frames{}\n", count, SIZES.size(), panels, frames, cold ? ", cold font cache" : "");
+    std::cout << std::format("simple_ui constructed: {:.2f} ms\n", construct_ms);
+    std::cout << std::format("first frame: {:.2f} ms ({:.3f} us/string)\n", first_ms, 1000.0 * first_ms / count);
+    std::cout << std::format("later frames: {:.3f} ms ({:.3f} us/string)\n", frame_ms, 1000.0 * frame_ms / count);
+    std::cout << std::format("ui: {} draw commands in {} draw calls per frame\n",
+                             ui.render_stats().commands, ui.render_stats().draw_calls);
+
+    constexpr std::size_t LOOKUP_REPEATS = 100000;
+    std::cout << std::format("glyph lookup: {:.1f} ns in ASCII text, {:.1f} ns in accented text\n",
+                             time_lookups(*ui.get_font(), ASCII_TEXT, LOOKUP_REPEATS),
+                             time_lookups(*ui.get_font(), UNICODE_TEXT, LOOKUP_REPEATS));
+
+    const auto& stats = ui.get_font()->layout_stats();
+    const std::size_t lookups = stats.hits + stats.misses;
+    std::cout << std::format("layout cache: {} hits, {} misses ({:.1f}% hit rate)\n",
+                             stats.hits, stats.misses, lookups > 0 ? 100.0 * stats.hits / lookups : 0.0);
+    return 0;
+}
@@ -12,14 +12,18 @@
 #include <sprocket/core/events.h>
 #include <sprocket/core/input_codes.h>
 #include <sprocket/core/log.h>
-#include <sprocket/core/Window.h>
+#include <sprocket/core/window.h>
 #include <sprocket/graphics/camera.h>
 #include <sprocket/graphics/render_context.h>
+#include <sprocket/graphics/render_stats.h>
 #include <sprocket/graphics/renderers/pbr_renderer.h>
 #include <sprocket/ui/ImGuiXtra.h>
 #include <sprocket/utility/views.h>
 
+#include <cinttypes>
 #include <cmath>
+#include <cstdint>
+#include <format>
 
 using namespace spkt;
 
@@ -100,11 +104,26 @@ void SunInfoPanel(imgui_ui& ui, day_night_cycle& cycle)
     ImGui::End();
 }
 
-void ShaderInfoPanel(imgui_ui& ui, shader& shader)
+void ShaderInfoPanel(imgui_ui& ui, pbr_renderer& renderer)
 {
     static std::string compileStatus;
+    static std::uint32_t variant = 0;
 
     ImGui::Begin("Shader");
+
+    // Each variant is preprocessed with its own defines, so they are edited separately.
+    const auto& variants = renderer.static_shaders();
+    if (ImGui::BeginCombo("Variant", variants.describe(variant).c_str())) {
+        for (std::uint32_t key : variants.keys()) {
+            if (ImGui::Selectable(variants.describe(key).c_str(), key == variant)) {
+                variant = key;
+                compileStatus.clear();
+            }
+        }
+        ImGui::EndCombo();
+    }
+    auto& shader = renderer.static_shader(variant);
+
     if(ImGui::Button("Recompile")) {
         bool result = shader.reload();
         compileStatus ="Shader compile:";
@@ -184,6 +203,7 @@ app::app(spkt::window* window)
     , d_mode(mode::PLAYER)
     , d_scene_renderer(&d_asset_manager)
     , d_post_processor(d_window->width(), d_window->height())
+    , d_resolution(d_window->width(), d_window->height())
     , d_shadow_map(&d_asset_manager)
     , d_hovered_entity_ui(d_window)
     , d_dev_ui(window)
@@ -191,7 +211,7 @@ app::app(spkt::window* window)
 {
     using namespace spkt;
 
-    load_scene("Resources/Scene.yaml");
+    load_scene("resources/Scene.yaml");
 
     simple_ui_theme theme;
     theme.background_colour = SPACE_DARK;
@@ -209,14 +229,12 @@ app::app(spkt::window* window)
     sun.direction = d_cycle.sun_direction();
 
     d_post_processor.add_effect(
-        "Resources/Shaders/GaussH.vert", "Resources/Shaders/Gauss.frag"
-    );
-    d_post_processor.add_effect(
-        "Resources/Shaders/GaussV.vert", "Resources/Shaders/Gauss.frag"
+        "resources/Shaders/GaussH.vert", "resources/Shaders/Gauss.frag", 0.5f
     );
     d_post_processor.add_effect(
-        "Resources/Shaders/Negative.vert", "Resources/Shaders/Negative.frag"
+        "resources/Shaders/GaussV.vert", "resources/Shaders/Gauss.frag"
     );
+    d_post_processor.add_colour_transform("negative");
 }
 
 void app::load_scene(std::string_view file)
@@ -288,6 +306,7 @@ void app::on_event(spkt::event& event)
 
     if (auto data = event.get_if<window_resized_event>()) {
         d_post_processor.set_screen_size(data->width, data->height);
+        d_resolution.set_output_size(data->width, data->height);
     }
 
     if (auto data = event.get_if<mouse_pressed_event>()) {
@@ -386,15 +405,23 @@ void app::on_render()
     const auto& game_grid = get_singleton<game::GameGridSingleton>(d_scene.registry);
     auto& registry = d_scene.registry;
 
+    auto [proj, view] = get_proj_view_matrices();
+
     // Create the Shadow Map
-    float lambda = 5.0f; // TODO: Calculate the floor intersection point
-    auto& tc = registry.get<game::Transform3DComponent>(d_camera);
-    glm::vec3 target = tc.position + lambda * spkt::forwards(tc.orientation);
     auto sun = registry.find<game::SunComponent>();
-
-    d_shadow_map.begin_frame(target, registry.get<game::SunComponent>(sun).direction);
-    for (auto [mc, tc] : registry.view_get<game::StaticModelComponent, game::Transform3DComponent>()) {
-        d_shadow_map.add_mesh(mc.mesh, tc.position, tc.orientation, tc.scale);
+    d_shadow_map.begin_frame(proj, view, registry.get<game::SunComponent>(sun).direction);
+    for (auto entity : registry.view<game::StaticModelComponent>()) {
+        if (!registry.has<game::Transform3DComponent>(entity)) { continue; }
+        const auto& mc = registry.get<game::StaticModelComponent>(entity);
+        const auto& tc = registry.get<game::Transform3DComponent>(entity);
+
+        // Only entities following a path move, everything else on the grid is cached.
+        if (registry.has<game::PathComponent>(entity)) {
+            d_shadow_map.add_mesh(mc.mesh, tc.position, tc.orientation, tc.scale);
+        } else {
+            const auto id = static_cast<std::uint64_t>(entity);
+            d_shadow_map.add_static_mesh(id, mc.mesh, tc.position, tc.orientation, tc.scale);
+        }
     }
     d_shadow_map.end_frame();
 
@@ -402,10 +429,10 @@ void app::on_render()
         d_post_processor.start_frame();
     }
 
-    auto [proj, view] = get_proj_view_matrices();
-
+    d_resolution.begin_frame();
     d_scene_renderer.enable_shadows(d_shadow_map);
     draw_scene(d_scene_renderer, registry, proj, view);
+    d_resolution.end_frame();
 
     if (d_paused) {
         d_post_processor.end_frame();
@@ -496,10 +523,45 @@ void app::on_render()
         glm::mat4 proj = spkt::make_proj(cc.fov);
 
         SunInfoPanel(d_dev_ui, d_cycle);
-        ShaderInfoPanel(d_dev_ui, d_scene_renderer.static_shader());
+        ShaderInfoPanel(d_dev_ui, d_scene_renderer);
+
+        ImGui::Begin("Rendering");
+        bool pack_materials = d_scene_renderer.material_packing();
+        if (ImGui::Checkbox("Pack materials", &pack_materials)) {
+            d_scene_renderer.set_material_packing(pack_materials);
+        }
+        const auto& packer = d_scene_renderer.packed_materials();
+        ImGui::Text("Packed materials: %zu in %zu arrays", packer.material_count(), packer.array_count());
+        const auto& stats = spkt::last_frame_render_stats();
+        ImGui::Text("Draw calls: %" PRIu64, stats.draw_calls);
+        ImGui::Text("Texture binds: %" PRIu64, stats.texture_binds);
+        ImGui::Separator();
+        bool dynamic = d_resolution.is_enabled();
+        if (ImGui::Checkbox("Dynamic", &dynamic)) {
+            d_resolution.set_enabled(dynamic);
+        }
+        float target = d_resolution.target_frame_time();
+        if (ImGui::SliderFloat("Target (ms)", &target, 1.0f, 33.0f)) {
+            d_resolution.set_target_frame_time(target);
+        }
+        float bounds[2] = {d_resolution.min_scale(), d_resolution.max_scale()};
+        if (ImGui::SliderFloat2("Scale bounds", bounds, 0.25f, 1.0f)) {
+            d_resolution.set_scale_bounds(bounds[0], bounds[1]);
+        }
+        float sharpness = d_resolution.sharpness();
+        if (ImGui::SliderFloat("Sharpness", &sharpness, 0.0f, 1.0f)) {
+            d_resolution.set_sharpness(sharpness);
+        }
+        const auto size = d_resolution.render_size();
+        ImGui::Text("Scale %.2f (%dx%d), scene %.2f ms", d_resolution.scale(), size.x, size.y, d_resolution.gpu_time());
+        ImGui::End();
 
         ImGui::Begin("Shadow Map");
-        ImGuiXtra::Image(d_shadow_map.get_texture(), 500.0f);
+        ImGui::Text("Resolution: %d", d_shadow_map.settings().resolution);
+        ImGui::Text("Draws last frame: %zu", d_shadow_map.draw_count());
+        for (std::size_t i = 0; i != d_shadow_map.cascade_count(); ++i) {
+            ImGui::Text("Cascade %zu ends at %.2f", i, d_shadow_map.cascade(i).split_depth);
+        }
         ImGui::End();
 
         ImGui::ShowDemoWindow();
@@ -563,6 +625,10 @@ void app::on_render()
         game::save_registry_to_file(d_scene_file, registry, entity_filter);
         spkt::log::info("Done!");
     }
+
+    button_region.y += 60;
+    const auto& ui_stats = d_escape_menu.render_stats();
+    d_escape_menu.text(std::format("{} draw calls, {} commands", ui_stats.draw_calls, ui_stats.commands), 24.0f, button_region);
     
     d_escape_menu.end_panel();
     
@@ -5,6 +5,8 @@
 #include <game/ecs/scene.h>
 
 #include <sprocket/graphics/asset_manager.h>
+#include <sprocket/graphics/dynamic_resolution.h>
+#include <sprocket/graphics/pixel_buffer.h>
 #include <sprocket/graphics/post_processor.h>
 #include <sprocket/graphics/renderers/pbr_renderer.h>
 #include <sprocket/graphics/shadow_map.h>
@@ -25,6 +27,8 @@ enum class mode { PLAYER, EDITOR };
 class app
 {
     spkt::window* d_window;
+
+    spkt::pixel_unpack_pool d_pixel_pool;
     spkt::asset_manager d_asset_manager;
     
     mode d_mode;
@@ -35,8 +39,9 @@ class app
     game::entity d_worker;
     
     // RENDERING
-    spkt::pbr_renderer   d_scene_renderer;
-    spkt::post_processor d_post_processor;
+    spkt::pbr_renderer       d_scene_renderer;
+    spkt::post_processor     d_post_processor;
+    spkt::dynamic_resolution d_resolution;
 
     // Additional world setup
     day_night_cycle d_cycle;
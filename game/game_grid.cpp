@@ -15,7 +15,7 @@
 
 namespace {
 
-constexpr const char* GRID_SQUARE = "Resources/Models/Square.obj";
+constexpr const char* GRID_SQUARE = "resources/Models/Square.obj";
 
 template <typename T>
 T& get_singleton(game::registry& reg)
@@ -28,7 +28,7 @@ void add_rock_base(
     tr.scale = {1.1f, 1.1f, 1.1f};
 
     auto& mc = registry.emplace<game::StaticModelComponent>(entity);
-    mc.mesh = "Resources/Models/Rock.obj";
+    mc.mesh = "resources/Models/Rock.obj";
     mc.material = material;
 
     // Add the new entity to the grid.
@@ -56,8 +56,8 @@ void add_tree(game::registry& registry, glm::ivec2 position)
     tr.scale = {r, r, r};
 
     auto& mc = registry.emplace<game::StaticModelComponent>(entity);
-    mc.mesh = "Resources/Models/BetterTree.obj";
-    mc.material = "Resources/Materials/tree.yaml";
+    mc.mesh = "resources/Models/BetterTree.obj";
+    mc.material = "resources/Materials/tree.yaml";
 
     // Add the new entity to the grid.
     auto tile_map = registry.find<game::TileMapSingleton>();
@@ -68,20 +68,20 @@ void add_tree(game::registry& registry, glm::ivec2 position)
 
 void add_rock(game::registry& registry, glm::ivec2 position)
 {
-    add_rock_base(registry, position, "Resources/Materials/rock.yaml", "Rock");
+    add_rock_base(registry, position, "resources/Materials/rock.yaml", "Rock");
 }
 
 void add_iron(game::registry& registry, glm::ivec2 position)
 {
-    add_rock_base(registry, position, "Resources/Materials/iron.yaml", "Iron");
+    add_rock_base(registry, position, "resources/Materials/iron.yaml", "Iron");
 }
 
 void add_tin(game::registry& registry, glm::ivec2 position)
 {
-    add_rock_base(registry, position, "Resources/Materials/tin.yaml", "Tin");
+    add_rock_base(registry, position, "resources/Materials/tin.yaml", "Tin");
 }
 
 void add_mithril(game::registry& registry, glm::ivec2 position)
 {
-    add_rock_base(registry, position, "Resources/Materials/mithril.yaml", "Mithril");
+    add_rock_base(registry, position, "resources/Materials/mithril.yaml", "Mithril");
 }
\ No newline at end of file
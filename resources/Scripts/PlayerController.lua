@@ -84,7 +84,7 @@ function Fire(entity)
     local lc = LightComponent(vec3.new(1, 1, 1), 200)
     AddLightComponent(newEntity, lc)
 
-    local sc = ScriptComponent("Resources/Scripts/Grenade.lua", true)
+    local sc = ScriptComponent("resources/Scripts/Grenade.lua", true)
     AddScriptComponent(newEntity, sc)
 
     local pc = ParticleComponent(0.01, vec3.new(0, 0, 0), 1, vec3.new(0, 0, 0), vec3.new(1, 1, 1), 1)
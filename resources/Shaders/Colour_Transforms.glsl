@@ -0,0 +1,7 @@
+// Per-pixel colour transforms that the post processor can fuse into the output of a
+// pass. Each takes and returns a colour.
+
+vec4 negative(vec4 colour)
+{
+    return vec4(vec3(1.0) - colour.rgb, 1.0);
+}
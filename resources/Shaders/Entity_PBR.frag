@@ -17,24 +17,63 @@ in Data
 
     mat3 tangent_space;
 
-    vec4 light_space_pos;
+    float view_depth;
     vec3 to_camera;
+
+#ifdef USE_PACKED_MATERIAL
+    flat uint material_index;
+#endif
 } p_data;
 
 // Material Info
+// The USE_*_MAP defines are injected by the renderer for each shader variant, so unused
+// texture paths are compiled out rather than branched on per fragment.
+#ifdef USE_PACKED_MATERIAL
+// Each instance reads its material from a table of constants and texture array layers,
+// see material_packer. A layer of -1 means the constant is used instead.
+struct packed_material
+{
+    vec4  albedo;
+    vec4  params; // x metallic, y roughness
+    ivec4 layers; // albedo, normal, metallic, roughness
+};
+
+layout(std430, binding = 5) readonly buffer packed_materials
+{
+    packed_material u_materials[];
+};
+
+uniform sampler2DArray u_material_layers;
+
+// Every layer is sampled, even when unused, so derivatives stay well defined across
+// neighbouring instances with different materials.
+vec4 sample_layer(int layer)
+{
+    return texture(u_material_layers, vec3(p_data.texture_coords, max(layer, 0)));
+}
+#endif
+
+#ifdef USE_ALBEDO_MAP
 uniform sampler2D u_albedo_map;
-uniform sampler2D u_normal_map;
-uniform sampler2D u_metallic_map;
-uniform sampler2D u_roughness_map;
+#else
+uniform vec3 u_albedo;
+#endif
 
-uniform float u_use_albedo_map;
-uniform float u_use_normal_map;
-uniform float u_use_metallic_map;
-uniform float u_use_roughness_map;
+#ifdef USE_NORMAL_MAP
+uniform sampler2D u_normal_map;
+#endif
 
-uniform vec3  u_albedo;
+#ifdef USE_METALLIC_MAP
+uniform sampler2D u_metallic_map;
+#else
 uniform float u_metallic;
+#endif
+
+#ifdef USE_ROUGHNESS_MAP
+uniform sampler2D u_roughness_map;
+#else
 uniform float u_roughness;
+#endif
 
 // Lighting Information
 const int MAX_NUM_LIGHTS = 50;
@@ -50,7 +89,11 @@ uniform vec3  u_ambience_colour;
 uniform float u_ambience_brightness;
 
 // Shadows
-uniform sampler2D shadow_map;
+const int MAX_CASCADES = 4;
+uniform sampler2DArray shadow_map;
+uniform mat4  u_cascade_proj_view[MAX_CASCADES];
+uniform float u_cascade_splits[MAX_CASCADES];
+uniform int   u_cascade_count;
 
 const float PI = 3.14159265359;
 
@@ -117,17 +160,50 @@ vec3 calculate_light(
 
 void main()
 {
-    vec3 albedo = u_use_albedo_map > 0.5 ? texture(u_albedo_map, p_data.texture_coords).xyz : u_albedo;
+#ifdef USE_PACKED_MATERIAL
+    packed_material mat = u_materials[p_data.material_index];
+    vec4 albedo_sample = sample_layer(mat.layers.x);
+    vec4 normal_sample = sample_layer(mat.layers.y);
+    vec4 metallic_sample = sample_layer(mat.layers.z);
+    vec4 roughness_sample = sample_layer(mat.layers.w);
+
+    vec3 albedo = mat.layers.x >= 0 ? albedo_sample.xyz : mat.albedo.xyz;
+    float metallic = mat.layers.z >= 0 ? metallic_sample.r : mat.params.x;
+    float roughness = mat.layers.w >= 0 ? roughness_sample.r : mat.params.y;
 
-    float metallic = u_use_metallic_map > 0.5 ? texture(u_metallic_map, p_data.texture_coords).r : u_metallic;
-    float roughness = u_use_roughness_map > 0.5 ? texture(u_roughness_map, p_data.texture_coords).r : u_roughness;
- 
     vec3 N = normalize(p_data.world_normal);
-    if (u_use_normal_map > 0.5) {
-        N = texture(u_normal_map, p_data.texture_coords).rgb;
-        N = normalize(N * 2.0 - 1.0);
-        N = normalize(p_data.tangent_space * N);
+    if (mat.layers.y >= 0) {
+        vec2 N_xy = normal_sample.rg * 2.0 - 1.0;
+        N = normalize(p_data.tangent_space * vec3(N_xy, sqrt(max(1.0 - dot(N_xy, N_xy), 0.0))));
     }
+#else
+#ifdef USE_ALBEDO_MAP
+    vec3 albedo = texture(u_albedo_map, p_data.texture_coords).xyz;
+#else
+    vec3 albedo = u_albedo;
+#endif
+
+#ifdef USE_METALLIC_MAP
+    float metallic = texture(u_metallic_map, p_data.texture_coords).r;
+#else
+    float metallic = u_metallic;
+#endif
+
+#ifdef USE_ROUGHNESS_MAP
+    float roughness = texture(u_roughness_map, p_data.texture_coords).r;
+#else
+    float roughness = u_roughness;
+#endif
+ 
+#ifdef USE_NORMAL_MAP
+    // Only the xy of the normal is read so that two channel BC5 normal maps work too.
+    vec2 N_xy = texture(u_normal_map, p_data.texture_coords).rg * 2.0 - 1.0;
+    vec3 N = vec3(N_xy, sqrt(max(1.0 - dot(N_xy, N_xy), 0.0)));
+    N = normalize(p_data.tangent_space * N);
+#else
+    vec3 N = normalize(p_data.world_normal);
+#endif
+#endif
 
     vec3 V = normalize(p_data.to_camera);
 
@@ -135,22 +211,30 @@ void main()
     F0 = mix(F0, albedo, metallic);
 
     // Shadows
-    vec3 proj_coords = p_data.light_space_pos.xyz / p_data.light_space_pos.w;
-    proj_coords = 0.5 * proj_coords + 0.5;
-    float current_depth = proj_coords.z;
-    float d = dot(p_data.world_normal, -u_sun_direction);
-    
-    float shadow = 0;
-    vec2 texel_size = 1.0 / textureSize(shadow_map, 0);
-    for (int x = -1; x <= 1; ++x) {
-        for (int y= -1; y <= 1; ++y) {
-            float pcf_depth = texture(shadow_map, proj_coords.xy + vec2(x, y) * texel_size).r;
-            shadow += current_depth > pcf_depth ? 1.0 : 0.0;
+    float shadow = 0.0;
+    int cascade = 0;
+    while (cascade < u_cascade_count && p_data.view_depth > u_cascade_splits[cascade]) {
+        ++cascade;
+    }
+
+    if (cascade < u_cascade_count) {
+        vec4 light_space_pos = u_cascade_proj_view[cascade] * vec4(p_data.world_position, 1.0);
+        vec3 proj_coords = light_space_pos.xyz / light_space_pos.w;
+        proj_coords = 0.5 * proj_coords + 0.5;
+        float current_depth = proj_coords.z;
+
+        vec2 texel_size = 1.0 / textureSize(shadow_map, 0).xy;
+        for (int x = -1; x <= 1; ++x) {
+            for (int y= -1; y <= 1; ++y) {
+                vec2 uv = proj_coords.xy + vec2(x, y) * texel_size;
+                float pcf_depth = texture(shadow_map, vec3(uv, cascade)).r;
+                shadow += current_depth > pcf_depth ? 1.0 : 0.0;
+            }
         }
+        shadow /= 9.0;
+        if (shadow > 0.0) { shadow = 1.0; }
+        if (proj_coords.z > 1.0) { shadow = 0.0; }
     }
-    shadow /= 9.0;
-    if (shadow > 0.0) { shadow = 1.0; }
-    if (proj_coords.z > 1.0) { shadow = 0.0; }
     
     // reflectance
     vec3 Lo = vec3(0.0);
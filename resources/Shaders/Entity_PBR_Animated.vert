@@ -11,31 +11,9 @@ layout(location = 6) in vec4 bone_weights;
 
 const int MAX_BONES = 50;
 
-out Data
-{
-    vec3 world_position;
-    vec2 texture_coords;
-
-    vec3 world_normal;
-    vec3 world_tangent;
-    vec3 world_bitangent;
-
-    vec3 normal;
-    vec3 tangent;
-    vec3 bitangent;
-
-    mat3 tangent_space;
-
-    vec4 light_space_pos;
-    vec3 to_camera;
-} p_data;
+#include "Entity_PBR_Vertex.glsl"
 
-// Transforms
 uniform mat4 u_model_matrix;
-uniform mat4 u_proj_matrix;
-uniform mat4 u_view_matrix;
-uniform mat4 u_light_proj_view;
-
 uniform mat4 u_bone_transforms[MAX_BONES];
 
 void main()
@@ -57,25 +35,8 @@ void main()
         }
     }
 
-    vec3 position = total_position.xyz;
-    vec3 normal = total_normal.xyz;
-
-    vec4 world_pos = u_model_matrix * vec4(position, 1.0);
-    gl_Position = u_proj_matrix * u_view_matrix * world_pos;
-    
-    p_data.world_position = vec3(world_pos);
-    p_data.texture_coords = texture_coords;
-    
-    p_data.world_normal = mat3(u_model_matrix) * normal;
-    p_data.world_tangent = mat3(u_model_matrix) * tangent;
-    p_data.world_bitangent = mat3(u_model_matrix) * bitangent;
-
-    p_data.normal = normal;
-    p_data.tangent = tangent;
-    p_data.bitangent = bitangent;
-
-    p_data.tangent_space = mat3(u_model_matrix) * mat3(tangent, bitangent, normal);
-
-    p_data.light_space_pos = u_light_proj_view * world_pos;
-    p_data.to_camera = (inverse(u_view_matrix) * vec4(0.0, 0.0, 0.0, 1.0)).xyz - world_pos.xyz;
-}
\ No newline at end of file
+    write_vertex_data(
+        u_model_matrix, total_position.xyz, texture_coords,
+        total_normal.xyz, tangent, bitangent
+    );
+}
@@ -0,0 +1,55 @@
+// Shared outputs and transforms for the PBR vertex shaders.
+out Data
+{
+    vec3 world_position;
+    vec2 texture_coords;
+
+    // Tangent space unit vectors in world space
+    vec3 world_normal;
+    vec3 world_tangent;
+    vec3 world_bitangent;
+
+    // Tangent space unit vectors in model space
+    vec3 normal;
+    vec3 tangent;
+    vec3 bitangent;
+
+    mat3 tangent_space;
+
+    float view_depth;
+    vec3 to_camera;
+
+#ifdef USE_PACKED_MATERIAL
+    flat uint material_index;
+#endif
+} p_data;
+
+// Transforms
+uniform mat4 u_proj_matrix;
+uniform mat4 u_view_matrix;
+
+// Sets gl_Position and fills in the data passed to the fragment shader.
+void write_vertex_data(
+    mat4 model_matrix, vec3 position, vec2 texture_coords,
+    vec3 normal, vec3 tangent, vec3 bitangent)
+{
+    vec4 world_pos = model_matrix * vec4(position, 1.0);
+    vec4 view_pos = u_view_matrix * world_pos;
+    gl_Position = u_proj_matrix * view_pos;
+
+    p_data.world_position = vec3(world_pos);
+    p_data.texture_coords = texture_coords;
+
+    p_data.world_normal = mat3(model_matrix) * normal;
+    p_data.world_tangent = mat3(model_matrix) * tangent;
+    p_data.world_bitangent = mat3(model_matrix) * bitangent;
+
+    p_data.normal = normal;
+    p_data.tangent = tangent;
+    p_data.bitangent = bitangent;
+
+    p_data.tangent_space = mat3(model_matrix) * mat3(tangent, bitangent, normal);
+
+    p_data.view_depth = -view_pos.z;
+    p_data.to_camera = (inverse(u_view_matrix) * vec4(0.0, 0.0, 0.0, 1.0)).xyz - world_pos.xyz;
+}
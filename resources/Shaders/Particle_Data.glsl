@@ -0,0 +1,56 @@
+// Particle storage shared by the GPU particle compute shaders, must match gpu_particle
+// in sprocket/graphics/gpu_particles.h. A particle is dead when its life is <= 0.
+struct particle
+{
+	vec4 position_life; // xyz = position, w = remaining life
+	vec4 velocity;
+	vec4 acceleration;
+	vec4 scale;
+};
+
+layout(std430, binding = 0) buffer Particles
+{
+	particle particles[];
+};
+
+// Indices of free particle slots, used as a stack.
+layout(std430, binding = 1) buffer DeadList
+{
+	int dead_count;
+	int dead[];
+};
+
+// Packed model_instance structs (vec3 position, quat orientation, vec3 scale) read by
+// the instanced particle draw.
+layout(std430, binding = 2) buffer Instances
+{
+	float instances[];
+};
+
+// A DrawElementsIndirectCommand; only the instance count is written here.
+layout(std430, binding = 3) buffer Command
+{
+	uint index_count;
+	uint instance_count;
+	uint first_index;
+	int  base_vertex;
+	uint base_instance;
+};
+
+void write_instance(particle p)
+{
+	const uint i = 10 * atomicAdd(instance_count, 1);
+	instances[i + 0] = p.position_life.x;
+	instances[i + 1] = p.position_life.y;
+	instances[i + 2] = p.position_life.z;
+
+	// Identity orientation, stored as (x, y, z, w)
+	instances[i + 3] = 0.0;
+	instances[i + 4] = 0.0;
+	instances[i + 5] = 0.0;
+	instances[i + 6] = 1.0;
+
+	instances[i + 7] = p.scale.x;
+	instances[i + 8] = p.scale.y;
+	instances[i + 9] = p.scale.z;
+}
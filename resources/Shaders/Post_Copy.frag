@@ -0,0 +1,11 @@
+#version 400 core
+
+in vec2 textureCoords;
+
+uniform sampler2D colourTexture;
+
+#include "Post_Output.glsl"
+
+void main(void){
+	write_colour(texture(colourTexture, textureCoords));
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+// Shared output of the post processing passes. Colour transforms fused into a pass are
+// injected as COLOUR_TRANSFORM_N defines naming functions in Colour_Transforms.glsl, and
+// are applied in order before writing.
+#include "Colour_Transforms.glsl"
+
+out vec4 out_Colour;
+
+void write_colour(vec4 colour)
+{
+#ifdef COLOUR_TRANSFORM_0
+    colour = COLOUR_TRANSFORM_0(colour);
+#endif
+#ifdef COLOUR_TRANSFORM_1
+    colour = COLOUR_TRANSFORM_1(colour);
+#endif
+#ifdef COLOUR_TRANSFORM_2
+    colour = COLOUR_TRANSFORM_2(colour);
+#endif
+#ifdef COLOUR_TRANSFORM_3
+    colour = COLOUR_TRANSFORM_3(colour);
+#endif
+    out_Colour = colour;
+}
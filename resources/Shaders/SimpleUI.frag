@@ -11,6 +11,21 @@ layout (location = 0) out vec4 out_colour;
 
 void main()
 {
+    // Untextured geometry is marked with negative texture coordinates so that it can be
+    // batched with geometry using any texture.
+    if (pass_textureCoords.x < 0.0) {
+        out_colour = pass_colour;
+        return;
+    }
+
+#ifdef DISTANCE_FIELD
+    // The texture holds the distance to the glyph's edge, which is at 0.5. Smoothing over
+    // the change in distance across one pixel keeps the edge crisp at any size.
+    float dist = texture(tex, pass_textureCoords).r;
+    float width = max(fwidth(dist) * 0.5, 0.0001);
+    float a = smoothstep(0.5 - width, 0.5 + width, dist);
+    out_colour = vec4(pass_colour.rgb, pass_colour.a * a);
+#else
     if (texture_channels > 1) {
         out_colour = pass_colour * texture(tex, pass_textureCoords);
     }
@@ -18,4 +33,5 @@ void main()
         float a = texture(tex, pass_textureCoords).r;
         out_colour = vec4(pass_colour.rgb, pass_colour.a * a);
     }
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,35 @@
+#version 400 core
+
+in vec2 textureCoords;
+
+out vec4 out_Colour;
+
+// The scene, rendered into the lower left corner of the texture.
+uniform sampler2D u_source;
+
+uniform vec2  u_uv_scale;  // The size of the rendered region over the size of the texture
+uniform vec2  u_texel;     // The size of a texel of the texture in UV space
+uniform float u_sharpness; // Zero for a plain bilinear upscale
+
+// Samples never reach beyond the rendered region, which may hold older frames.
+vec3 sample_source(vec2 uv)
+{
+    return texture(u_source, clamp(uv, 0.5 * u_texel, u_uv_scale - 0.5 * u_texel)).rgb;
+}
+
+void main(void)
+{
+    vec2 uv = textureCoords * u_uv_scale;
+    vec3 colour = sample_source(uv);
+
+    // Unsharp mask: push the centre away from the average of its neighbours.
+    if (u_sharpness > 0.0) {
+        vec3 neighbours = sample_source(uv + vec2(u_texel.x, 0.0))
+                        + sample_source(uv - vec2(u_texel.x, 0.0))
+                        + sample_source(uv + vec2(0.0, u_texel.y))
+                        + sample_source(uv - vec2(0.0, u_texel.y));
+        colour = max(colour + u_sharpness * (colour - 0.25 * neighbours), vec3(0.0));
+    }
+
+    out_Colour = vec4(colour, 1.0);
+}
@@ -3,10 +3,15 @@
 #include <sprocket/core/window.h>
 #include <sprocket/core/log.h>
 #include <sprocket/core/timer.h>
+#include <sprocket/graphics/gpu_profiler.h>
+#include <sprocket/graphics/pixel_buffer.h>
+#include <sprocket/graphics/render_stats.h>
 
+#include <chrono>
 #include <concepts>
 #include <exception>
 #include <format>
+#include <string>
 #include <type_traits>
 #include <utility>
 
@@ -15,6 +20,9 @@ namespace spkt {
 struct run_options
 {
     bool show_frame_rate = false;
+
+    // If set, per-frame render statistics are written to this CSV file.
+    std::string render_stats_csv;
 };
 
 template <typename T>
@@ -35,12 +43,23 @@ int run(App& app, window& window, const run_options& options = {})
         app.on_event(event);
     });
 
+    if (!options.render_stats_csv.empty()) {
+        set_render_stats_csv(options.render_stats_csv);
+    }
+
     while (window.is_running()) {
         window.begin_frame();
+        gpu_profiler::get().begin_frame();
 
         double dt = watch.on_update();
         app.on_update(dt);
         app.on_render();
+        end_render_stats_frame();
+
+        // Recycles the pixel buffers of the textures uploaded this frame once the GPU is done.
+        if (auto* pool = pixel_unpack_pool::instance()) {
+            pool->collect();
+        }
 
         if (options.show_frame_rate) {
             window.set_name(std::format("{} [FPS: {}]", name, watch.frame_rate()));
@@ -52,13 +71,31 @@ int run(App& app, window& window, const run_options& options = {})
     return 0;
 }
 
+// Logs how long constructing the application took, which is most of the time to start up.
+class startup_timer
+{
+    std::string                           d_name;
+    std::chrono::steady_clock::time_point d_start = std::chrono::steady_clock::now();
+
+public:
+    explicit startup_timer(const std::string& name) : d_name(name) {}
+
+    void stop() const
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - d_start;
+        log::info("{} started in {:.1f} ms", d_name, std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+};
+
 // If the application type only needs a window* to be constructed, the entire run loop
 // can be further encapsulated for the user.
 template <runnable App> requires std::constructible_from<App, spkt::window*>
 int run_app(const std::string& name)
 {
     spkt::window window{name};
+    startup_timer startup{name};
     App app{&window};
+    startup.stop();
     return spkt::run(app, window);
 }
 
@@ -66,7 +103,9 @@ template <runnable App> requires std::constructible_from<App, spkt::window*>
 int run_app_framerate(const std::string& name)
 {
     spkt::window window{name};
+    startup_timer startup{name};
     App app{&window};
+    startup.stop();
     spkt::run_options options;
     options.show_frame_rate = true;
     return spkt::run(app, window, options);
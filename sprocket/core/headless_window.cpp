@@ -0,0 +1,218 @@
+#include "window.h"
+
+#include <sprocket/core/events.h>
+#include <sprocket/core/log.h>
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdlib>
+
+// A window backend with no visible window, for running on machines without a display
+// such as build servers. An OpenGL 4.5 core context is created through EGL, preferring
+// Mesa's surfaceless platform, and rendered into a pbuffer surface of the window's size
+// so that framebuffer 0 behaves as it does on screen. There is no input, so no input
+// events are ever produced.
+
+namespace spkt {
+
+struct window_impl
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+	EGLSurface surface = EGL_NO_SURFACE;
+	std::uint32_t vao = 0;
+
+	std::string clipboard;
+};
+
+namespace {
+
+EGLDisplay get_display()
+{
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+	const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT")
+	);
+	if (get_platform_display) {
+		EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display != EGL_NO_DISPLAY) {
+			return display;
+		}
+	}
+#endif
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+}
+
+window::window(const std::string& name, std::uint32_t width, std::uint32_t height)
+	: d_impl(std::make_unique<window_impl>())
+	, d_data({name, width, height, {1.0, 1.0, 1.0}})
+{
+	d_impl->display = get_display();
+	EGLint egl_major = 0;
+	EGLint egl_minor = 0;
+	if (d_impl->display == EGL_NO_DISPLAY || !eglInitialize(d_impl->display, &egl_major, &egl_minor)) {
+		log::fatal("Failed to initialise EGL");
+		std::exit(-1);
+	}
+	log::info("EGL version: {}.{}", egl_major, egl_minor);
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE,        8,
+		EGL_GREEN_SIZE,      8,
+		EGL_BLUE_SIZE,       8,
+		EGL_ALPHA_SIZE,      8,
+		EGL_DEPTH_SIZE,      24,
+		EGL_STENCIL_SIZE,    8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglChooseConfig(d_impl->display, config_attribs, &config, 1, &num_configs) || num_configs == 0) {
+		log::fatal("Failed to find an EGL config");
+		std::exit(-2);
+	}
+
+	const EGLint surface_attribs[] = {
+		EGL_WIDTH,  (EGLint)d_data.width,
+		EGL_HEIGHT, (EGLint)d_data.height,
+		EGL_NONE
+	};
+	d_impl->surface = eglCreatePbufferSurface(d_impl->display, config, surface_attribs);
+	if (d_impl->surface == EGL_NO_SURFACE) {
+		log::fatal("Failed to create EGL surface");
+		std::exit(-2);
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION,       4,
+		EGL_CONTEXT_MINOR_VERSION,       5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	d_impl->context = eglCreateContext(d_impl->display, config, EGL_NO_CONTEXT, context_attribs);
+	if (d_impl->context == EGL_NO_CONTEXT) {
+		log::fatal("Failed to create an OpenGL 4.5 context");
+		std::exit(-2);
+	}
+
+	eglMakeCurrent(d_impl->display, d_impl->surface, d_impl->surface, d_impl->context);
+
+	// Initialise GLAD
+	if (0 == gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		log::fatal("Failed to initialise GLAD");
+		std::exit(-3);
+	}
+
+	int version_major;
+	int version_minor;
+	glGetIntegerv(GL_MAJOR_VERSION, &version_major);
+	glGetIntegerv(GL_MINOR_VERSION, &version_minor);
+	log::info("OpenGL version: {}.{} ({})", version_major, version_minor, (const char*)glGetString(GL_RENDERER));
+
+	// Set OpenGL error callback
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback([](GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void*) {
+		switch (severity) {
+			case GL_DEBUG_SEVERITY_NOTIFICATION: return;
+			case GL_DEBUG_SEVERITY_LOW: {
+				log::info("{}, {}, {}, {}, {}", source, type, id, length, message);
+			} break;
+			case GL_DEBUG_SEVERITY_MEDIUM: {
+				log::warn("{}, {}, {}, {}, {}", source, type, id, length, message);
+			} break;
+			case GL_DEBUG_SEVERITY_HIGH: {
+				log::error("{}, {}, {}, {}, {}", source, type, id, length, message);
+			} break;
+		}
+	}, nullptr);
+
+	glViewport(0, 0, d_data.width, d_data.height);
+
+	glGenVertexArrays(1, &d_impl->vao);
+	glBindVertexArray(d_impl->vao);
+}
+
+window::~window()
+{
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &d_impl->vao);
+
+	eglMakeCurrent(d_impl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(d_impl->display, d_impl->context);
+	eglDestroySurface(d_impl->display, d_impl->surface);
+	eglTerminate(d_impl->display);
+}
+
+void window::begin_frame()
+{
+	// Clear the screen
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	const auto& clear = d_data.clear_colour;
+	glClearColor(clear.r, clear.g, clear.b, 1.0);
+
+	d_data.mouse_scrolled = {0.0, 0.0};
+	d_data.mouse_offset = {0.0, 0.0};
+}
+
+void window::end_frame()
+{
+	eglSwapBuffers(d_impl->display, d_impl->surface);
+}
+
+void window::set_clear_colour(const glm::vec3& colour)
+{
+	d_data.clear_colour = colour;
+}
+
+void window::set_event_handler(const event_handler& handler)
+{
+	d_data.callback = handler;
+}
+
+void window::set_cursor_visibility(bool)
+{
+}
+
+void window::set_fullscreen()
+{
+	log::warn("Headless windows cannot be made fullscreen");
+}
+
+void window::set_windowed(int, int)
+{
+	log::warn("Headless windows cannot be resized");
+}
+
+glm::vec2 window::mouse_position() const
+{
+	return d_data.mouse_position;
+}
+
+void window::set_name(const std::string& name)
+{
+	d_data.name = name;
+}
+
+const char* window::get_clipboard_data() const
+{
+	return d_impl->clipboard.c_str();
+}
+
+void window::set_clipboard_data(const std::string& text) const
+{
+	d_impl->clipboard = text;
+}
+
+void* window::native_handle() const
+{
+	return nullptr;
+}
+
+}
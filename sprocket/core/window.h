@@ -8,10 +8,6 @@
 #include <memory>
 #include <string>
 
-#ifndef _WIN32
-#error "Sprocket currently only supports Windows"
-#endif
-
 namespace spkt {
 
 using event_handler = std::function<void(spkt::event&)>;
@@ -1,4 +1,5 @@
 #pragma once
+#include <sprocket/graphics/cube_map.h>
 #include <sprocket/graphics/material.h>
 #include <sprocket/graphics/mesh.h>
 #include <sprocket/graphics/texture.h>
@@ -22,6 +23,8 @@ concept loadable = requires(const std::string& file)
     { T::load(file) } -> std::convertible_to<T>;
 };
 
+// Loads each asset the first time it is requested. T::load, which reads and decodes the
+// file, runs off the calling thread, and the default asset is returned until it finishes.
 template <loadable T>
 class single_asset_manager
 {
@@ -102,7 +105,8 @@ using asset_manager = spkt::basic_asset_manager<
     static_mesh,
     animated_mesh,
     texture,
-    material
+    material,
+    cube_map
 >;
 
 }
\ No newline at end of file
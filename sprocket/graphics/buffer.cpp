@@ -1,5 +1,7 @@
 #include "buffer.h"
 
+#include <sprocket/graphics/render_stats.h>
+
 #include <glad/glad.h>
 
 #include <ranges>
@@ -40,6 +42,37 @@ void bind_index_buffer(std::uint32_t vbo)
 void set_data(std::uint32_t vbo, std::size_t size, const void* data, buffer_usage usage)
 {
     glNamedBufferData(vbo, size, data, get_usage(usage));
+    SPKT_RECORD_RENDER_STAT(buffer_bytes, size);
+}
+
+void* new_mapped_vbo(std::uint32_t* vbo, std::size_t size)
+{
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, vbo);
+    glNamedBufferStorage(*vbo, size, nullptr, flags);
+    return glMapNamedBufferRange(*vbo, 0, size, flags);
+}
+
+void place_fence(void*& fence)
+{
+    if (fence) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void wait_fence(void*& fence)
+{
+    if (!fence) {
+        return;
+    }
+    const auto sync = static_cast<GLsync>(fence);
+    GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000); // 1ms
+    }
+    glDeleteSync(sync);
+    fence = nullptr;
 }
 
 }
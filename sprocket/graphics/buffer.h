@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <functional>
 #include <span>
@@ -24,6 +26,16 @@ void delete_vbo(std::uint32_t vbo);
 void bind_index_buffer(std::uint32_t vbo);
 void set_data(std::uint32_t vbo, std::size_t size, const void* data, buffer_usage usage);
 
+// Creates an immutable buffer of the given size that is persistently and coherently
+// mapped for writing, returning the mapped pointer.
+void* new_mapped_vbo(std::uint32_t* vbo, std::size_t size);
+
+// Inserts a fence after the commands submitted so far, replacing any existing one.
+void place_fence(void*& fence);
+
+// Blocks until the given fence, if any, has been signalled, then deletes it.
+void wait_fence(void*& fence);
+
 }
 
 template <typename T, buffer_usage Usage, void(*BindFunc)(std::uint32_t)> 
@@ -57,4 +69,82 @@ using vertex_buffer = basic_buffer<T, Usage, T::set_buffer_attributes>;
 template <std::unsigned_integral T, buffer_usage Usage = buffer_usage::STATIC>
 using index_buffer = basic_buffer<T, Usage, detail::bind_index_buffer>;
 
+// A persistently mapped buffer for data that is rewritten every frame, such as instance
+// data. It is split into REGIONS regions used round-robin, one per frame, so the CPU can
+// write the current frame's data directly into the buffer while the GPU is still reading
+// the previous frames'; a fence per region stops a region being overwritten before the
+// GPU is done with it. Elements are addressed by their index from the start of the whole
+// buffer so that they can be used directly as the base instance of a draw.
+template <spkt::buffer_element T>
+class streaming_buffer
+{
+public:
+    static constexpr std::size_t REGIONS = 3;
+
+private:
+    std::uint32_t d_vbo = 0;
+    T*            d_data = nullptr;
+    std::size_t   d_capacity; // Elements per region
+    std::size_t   d_region = 0;
+    std::size_t   d_used = 0; // Elements allocated in the current region
+
+    std::array<void*, REGIONS> d_fences = {};
+
+    void create()
+    {
+        d_data = static_cast<T*>(detail::new_mapped_vbo(&d_vbo, REGIONS * d_capacity * sizeof(T)));
+    }
+
+    void destroy()
+    {
+        for (auto& fence : d_fences) { detail::wait_fence(fence); }
+        detail::delete_vbo(d_vbo);
+    }
+
+    streaming_buffer(const streaming_buffer&) = delete;
+    streaming_buffer& operator=(const streaming_buffer&) = delete;
+
+public:
+    explicit streaming_buffer(std::size_t capacity) : d_capacity(capacity) { create(); }
+    ~streaming_buffer() { destroy(); }
+
+    // Fences the region written this frame and moves to the next one, waiting for the GPU
+    // to finish reading it if necessary. Should be called once per frame before allocating.
+    void next_frame()
+    {
+        detail::place_fence(d_fences[d_region]);
+        d_region = (d_region + 1) % REGIONS;
+        detail::wait_fence(d_fences[d_region]);
+        d_used = 0;
+    }
+
+    struct allocation
+    {
+        std::size_t  first; // Index of the first element, usable as a base instance
+        std::span<T> elements;
+    };
+
+    // Reserves count elements in the current region. If nothing has been allocated yet
+    // this frame, the buffer grows to fit; otherwise the allocation is truncated to the
+    // space remaining. The memory is write-combined, so it should be written sequentially
+    // and never read.
+    allocation allocate(std::size_t count)
+    {
+        if (d_used == 0 && count > d_capacity) {
+            destroy();
+            d_fences = {};
+            d_capacity = count;
+            create();
+        }
+        count = std::min(count, d_capacity - d_used);
+        const std::size_t first = d_region * d_capacity + d_used;
+        d_used += count;
+        return {first, {d_data + first, count}};
+    }
+
+    std::size_t capacity() const { return d_capacity; }
+
+    void bind() const { T::set_buffer_attributes(d_vbo); }
+};
+
 }
\ No newline at end of file
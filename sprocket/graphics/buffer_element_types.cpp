@@ -69,7 +69,26 @@ void model_instance::set_buffer_attributes(std::uint32_t vbo)
     glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(model_instance), (void*)offsetof(model_instance, orientation));
     glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(model_instance), (void*)offsetof(model_instance, scale));
 
+    // Only used by packed_model_instance, all draws share one vertex array.
+    glDisableVertexAttribArray(8);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void packed_model_instance::set_buffer_attributes(std::uint32_t vbo)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    for (int index : std::views::iota(5, 9)) {
+        glEnableVertexAttribArray(index);
+        glVertexAttribDivisor(index, 1);
+    }
+
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(packed_model_instance), (void*)offsetof(packed_model_instance, position));
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(packed_model_instance), (void*)offsetof(packed_model_instance, orientation));
+    glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(packed_model_instance), (void*)offsetof(packed_model_instance, scale));
+    glVertexAttribIPointer(8, 1, GL_UNSIGNED_INT, sizeof(packed_model_instance), (void*)offsetof(packed_model_instance, material));
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-}
\ No newline at end of file
+}
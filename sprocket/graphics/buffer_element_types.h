@@ -55,4 +55,16 @@ struct model_instance
     static void set_buffer_attributes(std::uint32_t vbo);
 };
 
-}
\ No newline at end of file
+// A model instance drawn with a packed material, see material_packer. The material is an
+// index into the packed material table.
+struct packed_model_instance
+{
+    glm::vec3     position;
+    glm::quat     orientation;
+    glm::vec3     scale;
+    std::uint32_t material;
+
+    static void set_buffer_attributes(std::uint32_t vbo);
+};
+
+}
@@ -1,43 +1,164 @@
 #include "cube_map.h"
 
+#include <sprocket/core/log.h>
+#include <sprocket/graphics/texture.h>
+#include <sprocket/utility/parallel.h>
+
 #include <glad/glad.h>
-#include <stb_image.h>
+#include <yaml-cpp/yaml.h>
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace spkt {
-    
-cube_map::cube_map(const std::array<std::string, 6>& faceFiles)
+namespace {
+
+std::size_t face_bytes(texture_format format, int width, int height, int mip_levels)
 {
-    glGenTextures(1, &d_id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, d_id);
+    std::size_t size = 0;
+    for (int level = 0; level != mip_levels; ++level) {
+        size += mip_size(format, std::max(width >> level, 1), std::max(height >> level, 1));
+    }
+    return size;
+}
 
-    for (std::uint32_t i = 0; i != faceFiles.size(); ++i) {
-        int bpp = 0;
-        unsigned char* data = stbi_load(faceFiles[i].c_str(),
-            &d_width, &d_height, &bpp, 0);
-
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                     0, GL_RGB, d_width, d_height,
-                     0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
-    }
-    
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    
-    // Unbind the texture now it is set up.
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+cube_map_data load_dds(const std::string& file)
+{
+    std::ifstream stream(file, std::ios::binary);
+    const auto info = dds::read_header(stream);
+    if (!info || !info->cube_map) {
+        log::error("'{}' is not a DDS cube map in a supported format", file);
+        return {};
+    }
+
+    cube_map_data data;
+    data.width = info->width;
+    data.height = info->height;
+    data.format = info->format;
+    data.mip_levels = info->mip_levels;
+
+    const std::size_t size = face_bytes(data.format, data.width, data.height, data.mip_levels);
+    for (auto& face : data.faces) {
+        face = pixel_buffer::allocate(size);
+        stream.read(reinterpret_cast<char*>(face.data()), size);
+    }
+    if (!stream) {
+        log::error("'{}' is truncated", file);
+        return {};
+    }
+    return data;
+}
+
+}
+
+cube_map::cube_map(const cube_map_data& data)
+    : d_width(data.width)
+    , d_height(data.height)
+{
+    if (d_width <= 0 || d_height <= 0) {
+        return;
+    }
+
+    const GLenum format = gl_internal_format(data.format);
+    glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &d_id);
+    glTextureStorage2D(d_id, data.mip_levels, format, d_width, d_height);
+
+    // Faces are uploaded as the layers of the cube map, from the unpack pool if they
+    // were decoded into it.
+    for (int face = 0; face != 6; ++face) {
+        const auto& bytes = data.faces[face];
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bytes.unpack_buffer());
+        std::size_t offset = 0;
+        for (int level = 0; level != data.mip_levels; ++level) {
+            const int width = std::max(d_width >> level, 1);
+            const int height = std::max(d_height >> level, 1);
+            const std::size_t size = mip_size(data.format, width, height);
+            const unsigned char* pixels = bytes.source() + offset;
+            if (is_compressed(data.format)) {
+                glCompressedTextureSubImage3D(d_id, level, 0, 0, face, width, height, 1, format, (GLsizei)size, pixels);
+            } else {
+                glTextureSubImage3D(d_id, level, 0, 0, face, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            }
+            offset += size;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glTextureParameteri(d_id, GL_TEXTURE_MIN_FILTER, data.mip_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTextureParameteri(d_id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(d_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(d_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(d_id, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 }
 
 cube_map::~cube_map()
 {
-    glDeleteTextures(1, &d_id);
+    if (d_id > 0) { glDeleteTextures(1, &d_id); }
+}
+
+cube_map_data cube_map::load(const std::string& file)
+{
+    if (std::filesystem::path(file).extension() == ".dds") {
+        return load_dds(file);
+    }
+
+    std::ifstream stream(file);
+    std::stringstream sstream;
+    sstream << stream.rdbuf();
+    YAML::Node data = YAML::Load(sstream.str());
+
+    const auto faces = data["Faces"];
+    if (!faces || !faces.IsSequence() || faces.size() != 6) {
+        log::error("Cube map '{}' must list six faces", file);
+        return {};
+    }
+
+    std::array<std::string, 6> face_files;
+    for (std::size_t i = 0; i != face_files.size(); ++i) {
+        face_files[i] = faces[i].as<std::string>();
+    }
+    return load_faces(face_files);
+}
+
+cube_map_data cube_map::load_faces(const std::array<std::string, 6>& faceFiles)
+{
+    // The faces are decoded on the shared job pool, with this thread taking a share.
+    auto chunks = parallel_for_chunks(faceFiles.size(), 1, [&](std::size_t begin, std::size_t end) {
+        std::vector<texture_data> loaded;
+        for (std::size_t i = begin; i != end; ++i) {
+            loaded.push_back(texture::load(faceFiles[i]));
+        }
+        return loaded;
+    });
+    std::array<texture_data, 6> faces;
+    auto next = faces.begin();
+    for (auto& chunk : chunks) {
+        next = std::ranges::move(chunk, next).out;
+    }
+
+    cube_map_data data;
+    data.width = faces[0].width;
+    data.height = faces[0].height;
+    data.format = faces[0].format;
+    data.mip_levels = faces[0].mip_levels;
+    for (std::size_t i = 0; i != faces.size(); ++i) {
+        const auto& face = faces[i];
+        const bool matches = face.width == data.width && face.height == data.height
+            && face.format == data.format && face.mip_levels == data.mip_levels;
+        if (face.width <= 0 || !matches || face.base_level != 0) {
+            log::error("Cube map face '{}' is missing or does not match the other faces", faceFiles[i]);
+            return {};
+        }
+        data.faces[i] = std::move(faces[i].bytes);
+    }
+    return data;
 }
 
 void cube_map::bind() const
@@ -51,4 +172,4 @@ void cube_map::unbind() const
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
-}
\ No newline at end of file
+}
@@ -1,21 +1,49 @@
 #pragma once
+#include <sprocket/graphics/dds.h>
+#include <sprocket/graphics/pixel_buffer.h>
+
 #include <array>
 #include <string>
 #include <cstddef>
 
 namespace spkt {
 
+struct cube_map_data
+{
+    int width = 0; // Of each face
+    int height = 0;
+
+    texture_format format = texture_format::RGBA8;
+    int mip_levels = 1;
+
+    // Indexed as the GL_TEXTURE_CUBE_MAP_* targets, +X, -X, +Y, -Y, +Z, -Z. Each holds
+    // its face's mip levels in turn, largest first.
+    std::array<pixel_buffer, 6> faces;
+};
+
 class cube_map
 {
-    std::uint32_t d_id;
+    std::uint32_t d_id = 0;
+
+    int d_width = 0;
+    int d_height = 0;
 
-    int d_width;
-    int d_height;
+    cube_map(const cube_map&) = delete;
+    cube_map& operator=(const cube_map&) = delete;
 
 public:
-    cube_map(const std::array<std::string, 6>& faceFiles);
+    cube_map() = default;
+    cube_map(const cube_map_data& data);
+    cube_map(const std::array<std::string, 6>& faceFiles) : cube_map(load_faces(faceFiles)) {}
     ~cube_map();
 
+    // Loads either a cooked .dds cube map, or a yaml file listing an image for each face
+    // under "Faces" in the order of cube_map_data::faces.
+    static cube_map_data load(const std::string& file);
+
+    // Decodes the six images in parallel.
+    static cube_map_data load_faces(const std::array<std::string, 6>& faceFiles);
+
     void bind() const;
     void unbind() const;
 
@@ -23,4 +51,4 @@ public:
     int height() const { return d_height; }
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+#include "dds.h"
+
+#include <algorithm>
+
+namespace spkt {
+namespace dds {
+namespace {
+
+std::optional<texture_format> read_format(const pixel_format& pf, std::istream& stream)
+{
+    if (pf.flags & DDPF_FOURCC) {
+        switch (pf.four_cc) {
+            case FOURCC_DXT1: return texture_format::BC1;
+            case FOURCC_DXT5: return texture_format::BC3;
+            case FOURCC_ATI2:
+            case FOURCC_BC5U: return texture_format::BC5;
+            case FOURCC_DX10: {
+                header_dx10 dx10;
+                stream.read(reinterpret_cast<char*>(&dx10), sizeof(dx10));
+                switch (dx10.dxgi_format) {
+                    case DXGI_FORMAT_R8G8B8A8_UNORM: return texture_format::RGBA8;
+                    case DXGI_FORMAT_BC1_UNORM: return texture_format::BC1;
+                    case DXGI_FORMAT_BC3_UNORM: return texture_format::BC3;
+                    case DXGI_FORMAT_BC5_UNORM: return texture_format::BC5;
+                }
+            } break;
+        }
+        return std::nullopt;
+    }
+
+    const bool is_rgba8 = (pf.flags & DDPF_RGB) && pf.rgb_bit_count == 32
+        && pf.r_mask == 0x000000ff && pf.g_mask == 0x0000ff00 && pf.b_mask == 0x00ff0000;
+    if (is_rgba8) {
+        return texture_format::RGBA8;
+    }
+    return std::nullopt;
+}
+
+}
+
+std::optional<file_info> read_header(std::istream& stream)
+{
+    std::uint32_t magic = 0;
+    header h;
+    stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    stream.read(reinterpret_cast<char*>(&h), sizeof(h));
+    if (!stream || magic != MAGIC || h.size != sizeof(header)) {
+        return std::nullopt;
+    }
+
+    const auto format = read_format(h.format, stream);
+    if (!format || !stream) {
+        return std::nullopt;
+    }
+
+    file_info info;
+    info.width = (int)h.width;
+    info.height = (int)h.height;
+    info.format = *format;
+    info.mip_levels = (h.flags & DDSD_MIPMAPCOUNT) ? std::max((int)h.mip_map_count, 1) : 1;
+    info.mip_levels = std::min(info.mip_levels, full_mip_count(info.width, info.height));
+    info.cube_map = (h.caps2 & DDSCAPS2_CUBEMAP) != 0;
+    if (info.cube_map && (h.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
+        return std::nullopt; // Partial cube maps are not supported
+    }
+    return info;
+}
+
+}
+}
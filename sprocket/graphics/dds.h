@@ -0,0 +1,153 @@
+#pragma once
+// Layout of the parts of the DirectDraw Surface (DDS) container used for cooked textures.
+// Only 2D textures with an optional mip chain are supported, in the formats listed in
+// texture_format, along with cube maps of them. Shared by the loaders in texture.cpp and
+// cube_map.cpp and the texture_cooker tool.
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+
+namespace spkt {
+
+enum class texture_format
+{
+    RGBA8, // Uncompressed, 4 bytes per pixel
+    BC1,   // RGB with 1 bit alpha, 8 bytes per 4x4 block (DXT1)
+    BC3,   // RGBA, 16 bytes per 4x4 block (DXT5)
+    BC5    // Two channel, 16 bytes per 4x4 block, for normal maps (ATI2)
+};
+
+inline constexpr bool is_compressed(texture_format format)
+{
+    return format != texture_format::RGBA8;
+}
+
+// The number of bytes in a single mip level of the given size.
+inline constexpr std::size_t mip_size(texture_format format, int width, int height)
+{
+    if (!is_compressed(format)) {
+        return 4 * (std::size_t)width * height;
+    }
+    const std::size_t blocks_x = (std::size_t)((width + 3) / 4);
+    const std::size_t blocks_y = (std::size_t)((height + 3) / 4);
+    const std::size_t block_bytes = format == texture_format::BC1 ? 8 : 16;
+    return blocks_x * blocks_y * block_bytes;
+}
+
+// The number of levels in a full mip chain down to 1x1.
+inline constexpr int full_mip_count(int width, int height)
+{
+    int levels = 1;
+    for (int size = width > height ? width : height; size > 1; size /= 2) {
+        ++levels;
+    }
+    return levels;
+}
+
+namespace dds {
+
+constexpr std::uint32_t make_four_cc(char a, char b, char c, char d)
+{
+    return (std::uint32_t)a | ((std::uint32_t)b << 8) | ((std::uint32_t)c << 16) | ((std::uint32_t)d << 24);
+}
+
+constexpr std::uint32_t MAGIC = make_four_cc('D', 'D', 'S', ' ');
+
+constexpr std::uint32_t FOURCC_DXT1 = make_four_cc('D', 'X', 'T', '1');
+constexpr std::uint32_t FOURCC_DXT5 = make_four_cc('D', 'X', 'T', '5');
+constexpr std::uint32_t FOURCC_ATI2 = make_four_cc('A', 'T', 'I', '2');
+constexpr std::uint32_t FOURCC_BC5U = make_four_cc('B', 'C', '5', 'U');
+constexpr std::uint32_t FOURCC_DX10 = make_four_cc('D', 'X', '1', '0');
+
+// DXGI formats that may appear in the extended DX10 header.
+constexpr std::uint32_t DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+constexpr std::uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+constexpr std::uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+constexpr std::uint32_t DXGI_FORMAT_BC5_UNORM = 83;
+
+// Header flags
+constexpr std::uint32_t DDSD_CAPS = 0x1;
+constexpr std::uint32_t DDSD_HEIGHT = 0x2;
+constexpr std::uint32_t DDSD_WIDTH = 0x4;
+constexpr std::uint32_t DDSD_PITCH = 0x8;
+constexpr std::uint32_t DDSD_PIXELFORMAT = 0x1000;
+constexpr std::uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr std::uint32_t DDSD_LINEARSIZE = 0x80000;
+
+// Pixel format flags
+constexpr std::uint32_t DDPF_ALPHAPIXELS = 0x1;
+constexpr std::uint32_t DDPF_FOURCC = 0x4;
+constexpr std::uint32_t DDPF_RGB = 0x40;
+
+// Caps
+constexpr std::uint32_t DDSCAPS_COMPLEX = 0x8;
+constexpr std::uint32_t DDSCAPS_TEXTURE = 0x1000;
+constexpr std::uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+// Caps2
+constexpr std::uint32_t DDSCAPS2_CUBEMAP = 0x200;
+constexpr std::uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xfc00; // +X, -X, +Y, -Y, +Z, -Z
+
+struct pixel_format
+{
+    std::uint32_t size = 32;
+    std::uint32_t flags;
+    std::uint32_t four_cc;
+    std::uint32_t rgb_bit_count;
+    std::uint32_t r_mask;
+    std::uint32_t g_mask;
+    std::uint32_t b_mask;
+    std::uint32_t a_mask;
+};
+
+// Follows the magic number.
+struct header
+{
+    std::uint32_t size = 124;
+    std::uint32_t flags;
+    std::uint32_t height;
+    std::uint32_t width;
+    std::uint32_t pitch_or_linear_size;
+    std::uint32_t depth;
+    std::uint32_t mip_map_count;
+    std::uint32_t reserved1[11];
+    pixel_format  format;
+    std::uint32_t caps;
+    std::uint32_t caps2;
+    std::uint32_t caps3;
+    std::uint32_t caps4;
+    std::uint32_t reserved2;
+};
+
+// Follows the header when format.four_cc is FOURCC_DX10.
+struct header_dx10
+{
+    std::uint32_t dxgi_format;
+    std::uint32_t resource_dimension;
+    std::uint32_t misc_flag;
+    std::uint32_t array_size;
+    std::uint32_t misc_flags2;
+};
+
+static_assert(sizeof(pixel_format) == 32);
+static_assert(sizeof(header) == 124);
+static_assert(sizeof(header_dx10) == 20);
+
+// What the loaders need to know from the headers.
+struct file_info
+{
+    int            width;
+    int            height;
+    int            mip_levels; // Stored for each face, at most a full chain
+    texture_format format;
+    bool           cube_map;
+};
+
+// Reads the magic number and headers, leaving the stream at the start of the pixel data.
+// Cube maps store each face in turn, each with its mip levels. Returns nullopt if the
+// stream is not a DDS file or is in an unsupported format.
+std::optional<file_info> read_header(std::istream& stream);
+
+}
+}
@@ -0,0 +1,167 @@
+#include "dynamic_resolution.h"
+
+#include <sprocket/graphics/gpu_profiler.h>
+#include <sprocket/graphics/texture.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace spkt {
+namespace {
+
+// How much each new timing moves the smoothed GPU time.
+constexpr float SMOOTHING = 0.2f;
+
+// The fraction of the way to the ideal scale moved per timing. Dropping quickly keeps
+// spikes short, while recovering slowly avoids oscillating about the target.
+constexpr float DECREASE_RATE = 0.5f;
+constexpr float INCREASE_RATE = 0.1f;
+
+// Relative changes smaller than this are ignored so the resolution settles.
+constexpr float DEAD_ZONE = 0.01f;
+
+static_mesh_data quad_mesh_data()
+{
+    return {
+        .vertices = {
+            { .position = {-1.0f, -1.0f, 0.0f}, .textureCoords = {0.0f, 0.0f} },
+            { .position = { 1.0f, -1.0f, 0.0f}, .textureCoords = {1.0f, 0.0f} },
+            { .position = { 1.0f,  1.0f, 0.0f}, .textureCoords = {1.0f, 1.0f} },
+            { .position = {-1.0f,  1.0f, 0.0f}, .textureCoords = {0.0f, 1.0f} }
+        },
+        .indices = {0, 1, 2, 0, 2, 3}
+    };
+}
+
+}
+
+dynamic_resolution::dynamic_resolution(int width, int height)
+    : d_target(nullptr)
+    , d_quad(std::make_unique<static_mesh>(quad_mesh_data()))
+    , d_upscale("resources/Shaders/Post_Copy.vert", "resources/Shaders/Upscale.frag")
+    , d_output_size(width, height)
+    , d_render_size(width, height)
+{
+    gpu_profiler::get().hold();
+    fit_target();
+}
+
+dynamic_resolution::~dynamic_resolution()
+{
+    if (d_enabled) {
+        gpu_profiler::get().release();
+    }
+}
+
+void dynamic_resolution::set_enabled(bool enabled)
+{
+    if (enabled != d_enabled) {
+        if (enabled) {
+            gpu_profiler::get().hold();
+        } else {
+            gpu_profiler::get().release();
+        }
+        d_enabled = enabled;
+    }
+}
+
+void dynamic_resolution::fit_target()
+{
+    const int width = std::max(1, (int)std::ceil(d_output_size.x * d_max_scale));
+    const int height = std::max(1, (int)std::ceil(d_output_size.y * d_max_scale));
+    if (!d_target) {
+        d_target = std::make_unique<frame_buffer>(width, height);
+    } else if (width > d_target->width() || height > d_target->height()) {
+        d_target->resize(std::max(width, d_target->width()), std::max(height, d_target->height()));
+    }
+}
+
+void dynamic_resolution::set_output_size(int width, int height)
+{
+    d_output_size = {width, height};
+    fit_target();
+}
+
+void dynamic_resolution::set_scale_bounds(float min_scale, float max_scale)
+{
+    d_max_scale = std::max(max_scale, 0.1f);
+    d_min_scale = std::clamp(min_scale, 0.1f, d_max_scale);
+    fit_target();
+}
+
+void dynamic_resolution::update_scale()
+{
+    // The profiler reads timings back a few frames late and skips frames that are not
+    // ready, so there is only a new timing when it has collected another frame.
+    const auto& profiler = gpu_profiler::get();
+    bool measured = false;
+    if (profiler.frames_collected() != d_frames_collected) {
+        d_frames_collected = profiler.frames_collected();
+        if (const auto timing = profiler.find(SCOPE_NAME)) {
+            const float ms = (float)*timing;
+            d_gpu_ms = d_gpu_ms > 0.0f ? d_gpu_ms + (ms - d_gpu_ms) * SMOOTHING : ms;
+            measured = true;
+        }
+    }
+
+    if (!d_enabled) {
+        d_scale = d_max_scale;
+        return;
+    }
+
+    if (measured && d_gpu_ms > 0.0f) {
+        // GPU time goes roughly with the pixel count, so with the square of the scale.
+        const float ideal = d_scale * std::sqrt(d_target_ms / d_gpu_ms);
+        const float rate = ideal < d_scale ? DECREASE_RATE : INCREASE_RATE;
+        const float next = d_scale + (ideal - d_scale) * rate;
+        if (std::abs(next - d_scale) > DEAD_ZONE * d_scale) {
+            d_scale = next;
+        }
+    }
+    d_scale = std::clamp(d_scale, d_min_scale, d_max_scale);
+}
+
+void dynamic_resolution::begin_frame()
+{
+    update_scale();
+
+    d_render_size = {
+        std::clamp((int)std::round(d_output_size.x * d_scale), 1, d_target->width()),
+        std::clamp((int)std::round(d_output_size.y * d_scale), 1, d_target->height())
+    };
+
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &d_previous_framebuffer);
+    d_target->bind(d_render_size.x, d_render_size.y);
+    gpu_profiler::get().push(SCOPE_NAME);
+}
+
+void dynamic_resolution::end_frame()
+{
+    gpu_profiler::get().pop();
+
+    d_target->unbind();
+    glBindFramebuffer(GL_FRAMEBUFFER, d_previous_framebuffer);
+
+    spkt::gpu_scope scope("upscale");
+    const GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    const glm::vec2 target_size{(float)d_target->width(), (float)d_target->height()};
+    const glm::vec2 render_size{(float)d_render_size.x, (float)d_render_size.y};
+    d_upscale.bind();
+    d_target->colour_texture().bind(0);
+    d_upscale.load("u_uv_scale", render_size / target_size);
+    d_upscale.load("u_texel", glm::vec2{1.0f} / target_size);
+    d_upscale.load("u_sharpness", d_sharpness);
+    d_quad->bind();
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+    if (depth_test) {
+        glEnable(GL_DEPTH_TEST);
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <sprocket/graphics/frame_buffer.h>
+#include <sprocket/graphics/mesh.h>
+#include <sprocket/graphics/shader.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string_view>
+
+namespace spkt {
+
+// Renders the scene at a reduced resolution when the GPU cannot keep up, then upscales
+// it to the output. The time the GPU spends between begin_frame and end_frame is
+// measured as a gpu_profiler scope, which the profiler is held recording for while this
+// is enabled, and the resolution scale is adjusted to hold that time at the target.
+//
+// To avoid reallocating render targets as the scale changes, the scene is rendered into
+// the lower left corner of a single target sized for the largest scale.
+class dynamic_resolution
+{
+public:
+    // The name of the gpu_profiler scope that the scene is timed with.
+    static constexpr std::string_view SCOPE_NAME = "scaled scene";
+
+private:
+    spkt::frame_buffer_ptr d_target;
+    spkt::static_mesh_ptr  d_quad;
+    spkt::shader           d_upscale;
+
+    // The profiler's count when the scene time was last read, see update_scale().
+    std::size_t d_frames_collected = 0;
+
+    glm::ivec2 d_output_size;
+    glm::ivec2 d_render_size;
+    int        d_previous_framebuffer = 0;
+
+    bool  d_enabled = true;
+    float d_target_ms = 14.0f;
+    float d_min_scale = 0.5f;
+    float d_max_scale = 1.0f;
+    float d_sharpness = 0.0f;
+
+    float d_scale = 1.0f;
+    float d_gpu_ms = 0.0f; // Smoothed over recent frames
+
+    dynamic_resolution(const dynamic_resolution&) = delete;
+    dynamic_resolution& operator=(const dynamic_resolution&) = delete;
+
+    // Reads the latest timing from the profiler and picks the scale for this frame.
+    void update_scale();
+
+    // Grows the target if the output at the largest scale no longer fits within it.
+    void fit_target();
+
+public:
+    dynamic_resolution(int width, int height);
+    ~dynamic_resolution();
+
+    // The size that end_frame upscales to. The target is only reallocated when this
+    // grows beyond what it can hold.
+    void set_output_size(int width, int height);
+
+    // Everything drawn between these two calls is rendered at the current scale. The
+    // output must be bound, with its viewport set, before begin_frame, and is bound again
+    // by end_frame with the upscaled scene drawn over it.
+    void begin_frame();
+    void end_frame();
+
+    // The GPU time between begin_frame and end_frame to aim for.
+    void set_target_frame_time(float milliseconds) { d_target_ms = milliseconds; }
+    float target_frame_time() const { return d_target_ms; }
+
+    // The scale applies to both dimensions, so the pixel count goes as its square.
+    void set_scale_bounds(float min_scale, float max_scale);
+    float min_scale() const { return d_min_scale; }
+    float max_scale() const { return d_max_scale; }
+
+    // While disabled, the scene is always rendered at the largest scale.
+    void set_enabled(bool enabled);
+    bool is_enabled() const { return d_enabled; }
+
+    // Zero for a plain bilinear upscale; higher values sharpen the result to recover
+    // some of the detail lost at lower scales.
+    void set_sharpness(float sharpness) { d_sharpness = sharpness; }
+    float sharpness() const { return d_sharpness; }
+
+    float scale() const { return d_scale; }
+    glm::ivec2 render_size() const { return d_render_size; }
+    float gpu_time() const { return d_gpu_ms; }
+};
+
+}
@@ -33,6 +33,18 @@ void frame_buffer::bind()
     d_viewport.set(0, 0, d_width, d_height);
 }
 
+void frame_buffer::bind(int width, int height)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, d_fbo);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    glEnable(GL_DEPTH_TEST);
+
+    d_viewport.set(0, 0, width, height);
+}
+
 void frame_buffer::unbind()
 {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
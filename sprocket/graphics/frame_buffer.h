@@ -30,6 +30,10 @@ public:
 
     void bind();
     void unbind();
+
+    // Binds for rendering into only the lower left width x height region, which is all
+    // that gets cleared.
+    void bind(int width, int height);
     
     void resize(int width, int height);
 
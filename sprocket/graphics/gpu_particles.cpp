@@ -0,0 +1,142 @@
+#include "gpu_particles.h"
+
+#include <sprocket/core/log.h>
+#include <sprocket/graphics/buffer_element_types.h>
+#include <sprocket/graphics/render_stats.h>
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <numeric>
+
+namespace spkt {
+namespace {
+
+// Shader storage binding points, must match Particle_Data.glsl and Particles_Emit.comp.
+constexpr GLuint PARTICLES_BINDING = 0;
+constexpr GLuint DEAD_LIST_BINDING = 1;
+constexpr GLuint INSTANCES_BINDING = 2;
+constexpr GLuint COMMAND_BINDING   = 3;
+constexpr GLuint EMITTED_BINDING   = 4;
+
+// Particle_Data.glsl writes instances as 10 tightly packed floats.
+static_assert(sizeof(model_instance) == 10 * sizeof(float));
+
+// Matches DrawElementsIndirectCommand.
+struct draw_command
+{
+    std::uint32_t index_count;
+    std::uint32_t instance_count;
+    std::uint32_t first_index;
+    std::int32_t  base_vertex;
+    std::uint32_t base_instance;
+};
+
+std::uint32_t new_storage_buffer(std::size_t size, const void* data)
+{
+    std::uint32_t buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, data, GL_DYNAMIC_STORAGE_BIT);
+    return buffer;
+}
+
+}
+
+gpu_particle_system::gpu_particle_system(std::size_t capacity)
+    : d_capacity(capacity)
+    , d_emit_shader("resources/Shaders/Particles_Emit.comp")
+    , d_simulate_shader("resources/Shaders/Particles_Simulate.comp")
+{
+    // Every slot starts dead, with a life of 0, and on the free list.
+    const std::vector<gpu_particle> particles(capacity, gpu_particle{});
+    d_particles = new_storage_buffer(capacity * sizeof(gpu_particle), particles.data());
+
+    std::vector<std::int32_t> dead_list(capacity + 1);
+    dead_list[0] = (std::int32_t)capacity;
+    std::iota(dead_list.begin() + 1, dead_list.end(), 0);
+    d_dead_list = new_storage_buffer(dead_list.size() * sizeof(std::int32_t), dead_list.data());
+
+    d_instances = new_storage_buffer(capacity * sizeof(model_instance), nullptr);
+
+    const draw_command command = {0, 0, 0, 0, 0};
+    d_command = new_storage_buffer(sizeof(draw_command), &command);
+
+    glCreateBuffers(1, &d_emitted);
+
+    if (!is_valid()) {
+        log::warn("GPU particles are unavailable, compute shaders failed to build");
+    }
+}
+
+gpu_particle_system::~gpu_particle_system()
+{
+    const std::uint32_t buffers[] = {d_particles, d_dead_list, d_instances, d_command, d_emitted};
+    glDeleteBuffers(5, buffers);
+}
+
+void gpu_particle_system::emit(const spkt::particle& particle)
+{
+    d_pending.push_back({
+        .position_life = {particle.position, particle.life},
+        .velocity = {particle.velocity, 0.0f},
+        .acceleration = {particle.acceleration, 0.0f},
+        .scale = {particle.scale, 0.0f}
+    });
+}
+
+void gpu_particle_system::update(float dt)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLES_BINDING, d_particles);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DEAD_LIST_BINDING, d_dead_list);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCES_BINDING, d_instances);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, d_command);
+
+    // The instances are rebuilt from scratch by the passes below.
+    const std::uint32_t zero = 0;
+    glNamedBufferSubData(d_command, offsetof(draw_command, instance_count), sizeof(zero), &zero);
+
+    d_simulate_shader.bind();
+    d_simulate_shader.load("u_dt", dt);
+    d_simulate_shader.load("u_capacity", (int)d_capacity);
+    d_simulate_shader.dispatch(d_capacity, GROUP_SIZE);
+
+    if (!d_pending.empty()) {
+        const std::size_t bytes = d_pending.size() * sizeof(gpu_particle);
+        if (d_pending.size() > d_emitted_capacity) {
+            d_emitted_capacity = d_pending.size();
+            glNamedBufferData(d_emitted, bytes, d_pending.data(), GL_STREAM_DRAW);
+        } else {
+            glNamedBufferSubData(d_emitted, 0, bytes, d_pending.data());
+        }
+        SPKT_RECORD_RENDER_STAT(buffer_bytes, bytes);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, EMITTED_BINDING, d_emitted);
+
+        // Emission reads the free list written by the simulation.
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        d_emit_shader.bind();
+        d_emit_shader.load("u_emit_count", (int)d_pending.size());
+        d_emit_shader.dispatch(d_pending.size(), GROUP_SIZE);
+        d_pending.clear();
+    }
+
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    glUseProgram(0);
+}
+
+void gpu_particle_system::draw(const spkt::static_mesh& mesh) const
+{
+    const auto index_count = (std::uint32_t)mesh.vertex_count();
+    glNamedBufferSubData(d_command, offsetof(draw_command, index_count), sizeof(index_count), &index_count);
+
+    mesh.bind();
+    model_instance::set_buffer_attributes(d_instances);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, d_command);
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // The instance count only exists on the GPU, so only the draw itself is recorded.
+    SPKT_RECORD_RENDER_STAT(instanced_draws, 1);
+    SPKT_RECORD_RENDER_STAT(draw_calls, 1);
+}
+
+}
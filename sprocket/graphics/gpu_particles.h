@@ -0,0 +1,75 @@
+#pragma once
+#include <sprocket/graphics/mesh.h>
+#include <sprocket/graphics/particles.h>
+#include <sprocket/graphics/shader.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spkt {
+
+// Must match the particle struct in Particle_Data.glsl.
+struct gpu_particle
+{
+    glm::vec4 position_life;
+    glm::vec4 velocity;
+    glm::vec4 acceleration;
+    glm::vec4 scale;
+};
+
+// Simulates particles on the GPU with compute shaders, for effects that emit more
+// particles than are practical to integrate and upload from the CPU each frame.
+//
+// Particles are emitted on the CPU into a queue which is uploaded once per update and
+// moved into free slots by a compute pass. A second pass integrates every slot, returns
+// the slots of dead particles to a free list and appends the survivors to an instance
+// buffer, along with an instance count that is consumed by an indirect draw, so nothing
+// is read back. As with particle_pool, emitting into a full system drops the particle.
+//
+// Construction can fail if compute shaders are unavailable, in which case is_valid
+// returns false and the caller should fall back to particle_pool.
+class gpu_particle_system
+{
+public:
+    static constexpr std::size_t GROUP_SIZE = 64; // Must match local_size_x in the shaders
+
+private:
+    std::size_t d_capacity;
+
+    spkt::compute_shader d_emit_shader;
+    spkt::compute_shader d_simulate_shader;
+
+    std::uint32_t d_particles;
+    std::uint32_t d_dead_list;
+    std::uint32_t d_instances;
+    std::uint32_t d_command;
+    std::uint32_t d_emitted;
+    std::size_t   d_emitted_capacity = 0;
+
+    std::vector<gpu_particle> d_pending;
+
+    gpu_particle_system(const gpu_particle_system&) = delete;
+    gpu_particle_system& operator=(const gpu_particle_system&) = delete;
+
+public:
+    explicit gpu_particle_system(std::size_t capacity = NUM_PARTICLES);
+    ~gpu_particle_system();
+
+    bool is_valid() const { return d_emit_shader.is_valid() && d_simulate_shader.is_valid(); }
+
+    // Queues a particle to be added in the next update.
+    void emit(const spkt::particle& particle);
+
+    // Integrates the live particles, then adds the particles queued since the last update.
+    void update(float dt);
+
+    std::size_t capacity() const { return d_capacity; }
+
+    // Draws an instance of the mesh for each live particle with the currently bound shader.
+    void draw(const spkt::static_mesh& mesh) const;
+};
+
+}
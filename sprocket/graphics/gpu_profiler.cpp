@@ -0,0 +1,122 @@
+#include "gpu_profiler.h"
+
+#include <glad/glad.h>
+
+#include <cassert>
+
+namespace spkt {
+
+gpu_profiler& gpu_profiler::get()
+{
+    // The queries are never explicitly deleted since the OpenGL context may already be
+    // gone by the time this is destroyed; they are freed along with the context.
+    static gpu_profiler profiler;
+    return profiler;
+}
+
+void gpu_profiler::set_enabled(bool enabled)
+{
+    d_enabled = enabled;
+    if (!enabled && d_holds == 0) {
+        d_results.clear();
+    }
+}
+
+void gpu_profiler::release()
+{
+    assert(d_holds > 0);
+    --d_holds;
+    if (!d_enabled && d_holds == 0) {
+        d_results.clear();
+    }
+}
+
+std::optional<double> gpu_profiler::find(std::string_view name) const
+{
+    for (const auto& timing : d_results) {
+        if (timing.name == name) {
+            return timing.milliseconds;
+        }
+    }
+    return std::nullopt;
+}
+
+std::size_t gpu_profiler::next_query()
+{
+    auto& f = d_frames[d_current];
+    if (f.queries_used == f.queries.size()) {
+        std::uint32_t id = 0;
+        glGenQueries(1, &id);
+        f.queries.push_back(id);
+    }
+    return f.queries_used++;
+}
+
+void gpu_profiler::collect(frame& f)
+{
+    if (f.scopes.empty()) {
+        return;
+    }
+
+    // Queries complete in order, so if the last is available then all of them are.
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(f.queries[f.queries_used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+        return;
+    }
+
+    d_results.clear();
+    for (const auto& scope : f.scopes) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(f.queries[scope.begin_query], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(f.queries[scope.end_query], GL_QUERY_RESULT, &end);
+        d_results.push_back({scope.name, scope.depth, (double)(end - begin) / 1'000'000.0});
+    }
+    ++d_frames_collected;
+}
+
+void gpu_profiler::begin_frame()
+{
+    assert(d_stack.empty());
+    d_in_frame = d_enabled || d_holds > 0;
+    if (!d_in_frame) {
+        return;
+    }
+
+    // The slot being reused was filled FRAME_LAG - 1 frames ago.
+    d_current = (d_current + 1) % FRAME_LAG;
+    auto& f = d_frames[d_current];
+    collect(f);
+    f.scopes.clear();
+    f.queries_used = 0;
+}
+
+void gpu_profiler::push(std::string_view name)
+{
+    if (!d_in_frame) {
+        return;
+    }
+
+    auto& f = d_frames[d_current];
+    const std::size_t query = next_query();
+    glQueryCounter(f.queries[query], GL_TIMESTAMP);
+    d_stack.push_back(f.scopes.size());
+    f.scopes.push_back({std::string{name}, d_stack.size() - 1, query, 0});
+}
+
+void gpu_profiler::pop()
+{
+    if (!d_in_frame) {
+        return;
+    }
+
+    assert(!d_stack.empty());
+    auto& f = d_frames[d_current];
+    const std::size_t query = next_query();
+    glQueryCounter(f.queries[query], GL_TIMESTAMP);
+    f.scopes[d_stack.back()].end_query = query;
+    d_stack.pop_back();
+}
+
+}
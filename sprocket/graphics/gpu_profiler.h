@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace spkt {
+
+struct gpu_timing
+{
+    std::string name;
+    std::size_t depth; // Nesting level of the scope, 0 for top level scopes
+    double      milliseconds;
+};
+
+// Measures the GPU time of named, possibly nested, scopes using GL_TIMESTAMP queries.
+// Queries are cycled through a ring of FRAME_LAG frames so that results are read back
+// once the GPU has finished with them rather than stalling the pipeline; the results
+// returned are therefore from a few frames ago. If a frame's queries are still not
+// ready when its slot comes round again, its results are skipped.
+//
+// Timestamps are used rather than GL_TIME_ELAPSED as elapsed-time queries cannot nest.
+class gpu_profiler
+{
+public:
+    static constexpr std::size_t FRAME_LAG = 4;
+
+private:
+    struct scope_record
+    {
+        std::string name;
+        std::size_t depth;
+        std::size_t begin_query;
+        std::size_t end_query;
+    };
+
+    struct frame
+    {
+        std::vector<std::uint32_t> queries;
+        std::size_t                queries_used = 0;
+        std::vector<scope_record>  scopes;
+    };
+
+    bool        d_enabled = false;
+    std::size_t d_holds = 0;
+    bool        d_in_frame = false;
+
+    std::array<frame, FRAME_LAG> d_frames;
+    std::size_t                  d_current = 0;
+    std::vector<std::size_t>     d_stack;
+
+    std::vector<gpu_timing> d_results;
+    std::size_t             d_frames_collected = 0;
+
+    std::size_t next_query();
+    void collect(frame& f);
+
+    gpu_profiler() = default;
+
+    gpu_profiler(const gpu_profiler&) = delete;
+    gpu_profiler& operator=(const gpu_profiler&) = delete;
+
+public:
+    // The profiler used by gpu_scope.
+    static gpu_profiler& get();
+
+    void set_enabled(bool enabled);
+    bool is_enabled() const { return d_enabled; }
+
+    // Keeps the profiler recording, whether or not it is enabled, until each hold is
+    // released. For systems that act on the timings, such as dynamic_resolution.
+    void hold() { ++d_holds; }
+    void release();
+
+    // The time of the first scope in results() with the given name, at any depth.
+    std::optional<double> find(std::string_view name) const;
+
+    // Starts a new frame of scopes. Called once per frame by spkt::run.
+    void begin_frame();
+
+    void push(std::string_view name);
+    void pop();
+
+    // The timings of the most recent frame whose queries have completed, in the order
+    // that the scopes were opened.
+    std::span<const gpu_timing> results() const { return d_results; }
+
+    // The number of frames whose results have been collected. This only changes when
+    // results() is replaced, so it tells a new frame's timings apart from ones already seen.
+    std::size_t frames_collected() const { return d_frames_collected; }
+};
+
+// Times the GPU work submitted during its lifetime. Does nothing while the profiler is
+// disabled.
+class gpu_scope
+{
+    gpu_scope(const gpu_scope&) = delete;
+    gpu_scope& operator=(const gpu_scope&) = delete;
+
+public:
+    explicit gpu_scope(std::string_view name) { gpu_profiler::get().push(name); }
+    ~gpu_scope() { gpu_profiler::get().pop(); }
+};
+
+}
@@ -10,6 +10,11 @@
 
 namespace spkt {
 
+std::uint32_t material::features() const
+{
+    return make_material_features(useAlbedoMap, useNormalMap, useMetallicMap, useRoughnessMap);
+}
+
 material material::load(const std::string& file)
 {
     std::string filepath = std::filesystem::absolute(file).string();
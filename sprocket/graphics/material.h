@@ -1,10 +1,31 @@
 #pragma once
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
 
 namespace spkt {
 
+// Optional inputs of a material. The combination that a material uses is its pipeline
+// key, which selects a shader variant with the unused branches compiled out and the set
+// of textures that need binding.
+enum material_feature : std::uint32_t
+{
+    MATERIAL_ALBEDO_MAP    = 1 << 0,
+    MATERIAL_NORMAL_MAP    = 1 << 1,
+    MATERIAL_METALLIC_MAP  = 1 << 2,
+    MATERIAL_ROUGHNESS_MAP = 1 << 3
+};
+
+constexpr std::uint32_t make_material_features(
+    bool albedo_map, bool normal_map, bool metallic_map, bool roughness_map)
+{
+    return (albedo_map    ? MATERIAL_ALBEDO_MAP    : 0u)
+         | (normal_map    ? MATERIAL_NORMAL_MAP    : 0u)
+         | (metallic_map  ? MATERIAL_METALLIC_MAP  : 0u)
+         | (roughness_map ? MATERIAL_ROUGHNESS_MAP : 0u);
+}
+
 struct material
 {
     std::string name;
@@ -23,6 +44,11 @@ struct material
     float     metallic = 0.0f;
     float     roughness = 1.0f;
 
+    // The pipeline key of this material, a combination of material_features.
+    std::uint32_t features() const;
+
+    bool operator==(const material&) const = default;
+
     static material load(const std::string& file);
     static void     save(const std::string& file, const material& material);
 };
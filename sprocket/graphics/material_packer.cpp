@@ -0,0 +1,147 @@
+#include "material_packer.h"
+
+#include <glad/glad.h>
+
+#include <cassert>
+
+namespace spkt {
+
+material_packer::material_packer(spkt::asset_manager* asset_manager)
+    : d_asset_manager(asset_manager)
+{
+    glCreateBuffers(1, &d_table_buffer);
+}
+
+material_packer::~material_packer()
+{
+    glDeleteBuffers(1, &d_table_buffer);
+}
+
+int material_packer::layer(std::size_t array, spkt::texture& tex)
+{
+    if (auto it = d_layers.find(&tex); it != d_layers.end() && it->second.first == array
+            && d_arrays[array]->texture_at(it->second.second) == &tex) {
+        return it->second.second;
+    }
+    const int layer = d_arrays[array]->add(tex);
+    d_layers[&tex] = {array, layer};
+    return layer;
+}
+
+bool material_packer::is_current(const entry& e) const
+{
+    return !e.packed || e.packed->array == NO_ARRAY
+        || d_arrays[e.packed->array]->generation() == e.generation;
+}
+
+std::optional<std::pair<std::size_t, glm::ivec4>> material_packer::pack_textures(
+    const std::array<spkt::texture*, 4>& textures)
+{
+    const spkt::texture* first = nullptr;
+    for (const auto* tex : textures) {
+        if (!tex) { continue; }
+        if (tex->is_streamed() || (first && !(tex->width() == first->width()
+                && tex->height() == first->height() && tex->format() == first->format()))) {
+            return std::nullopt;
+        }
+        if (!first) { first = tex; }
+    }
+
+    glm::ivec4 layers{-1};
+    if (!first) {
+        return std::pair{NO_ARRAY, layers};
+    }
+
+    const array_key key{first->width(), first->height(), first->format(), first->mip_levels()};
+    auto [it, inserted] = d_array_lookup.try_emplace(key, d_arrays.size());
+    if (inserted) {
+        d_arrays.push_back(std::make_unique<spkt::texture_array>(
+            first->width(), first->height(), first->format(), first->mip_levels()
+        ));
+    }
+
+    const std::size_t array = it->second;
+    for (std::size_t i = 0; i != textures.size(); ++i) {
+        if (!textures[i]) { continue; }
+        if (!d_arrays[array]->accepts(*textures[i])) {
+            return std::nullopt;
+        }
+        layers[(int)i] = layer(array, *textures[i]);
+    }
+    return std::pair{array, layers};
+}
+
+std::optional<material_packer::packed_material> material_packer::pack(const spkt::material& material)
+{
+    auto it = d_materials.find(&material);
+    if (it != d_materials.end() && it->second.material == material && is_current(it->second)) {
+        return it->second.packed;
+    }
+
+    // Order matches the layers in packed_material_data.
+    const std::uint32_t features = material.features();
+    const std::array<std::pair<material_feature, const std::string*>, 4> maps = {{
+        {MATERIAL_ALBEDO_MAP,    &material.albedoMap},
+        {MATERIAL_NORMAL_MAP,    &material.normalMap},
+        {MATERIAL_METALLIC_MAP,  &material.metallicMap},
+        {MATERIAL_ROUGHNESS_MAP, &material.roughnessMap}
+    }};
+
+    std::array<spkt::texture*, 4> textures = {};
+    for (std::size_t i = 0; i != maps.size(); ++i) {
+        if (!(features & maps[i].first)) { continue; }
+        auto& tex = d_asset_manager->get<spkt::texture>(*maps[i].second);
+        if (tex.width() == 0) {
+            return std::nullopt; // Still loading, try again next frame
+        }
+        textures[i] = &tex;
+    }
+
+    auto& entry = it != d_materials.end() ? it->second : d_materials[&material];
+    entry.material = material;
+
+    const auto packed = pack_textures(textures);
+    if (!packed) {
+        // An edit made the material unpackable, so its place in the table can be reused.
+        if (entry.packed) {
+            d_free_slots.push_back(entry.packed->index);
+        }
+        entry.packed = std::nullopt;
+        return std::nullopt;
+    }
+
+    // An edited material keeps its place in the table.
+    std::uint32_t index = 0;
+    if (entry.packed) {
+        index = entry.packed->index;
+    } else if (!d_free_slots.empty()) {
+        index = d_free_slots.back();
+        d_free_slots.pop_back();
+    } else {
+        index = (std::uint32_t)d_table.size();
+        d_table.emplace_back();
+    }
+    d_table[index] = {
+        .albedo = glm::vec4{material.albedo, 1.0f},
+        .params = glm::vec4{material.metallic, material.roughness, 0.0f, 0.0f},
+        .layers = packed->second
+    };
+    d_table_dirty = true;
+
+    entry.packed = packed_material{packed->first, index};
+    entry.generation = packed->first == NO_ARRAY ? 0 : d_arrays[packed->first]->generation();
+    return entry.packed;
+}
+
+void material_packer::bind_table()
+{
+    if (d_table_dirty) {
+        glNamedBufferData(
+            d_table_buffer, d_table.size() * sizeof(packed_material_data), d_table.data(), GL_DYNAMIC_DRAW
+        );
+        d_table_dirty = false;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PACKED_MATERIALS_BINDING, d_table_buffer);
+}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <sprocket/graphics/asset_manager.h>
+#include <sprocket/graphics/material.h>
+#include <sprocket/graphics/texture.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace spkt {
+
+// Shader storage binding of the packed material table, must match Entity_PBR.frag.
+static constexpr int PACKED_MATERIALS_BINDING = 5;
+
+// Must match the packed_material struct in Entity_PBR.frag.
+struct packed_material_data
+{
+    glm::vec4  albedo; // w unused
+    glm::vec4  params; // x metallic, y roughness
+    glm::ivec4 layers; // Of the albedo, normal, metallic and roughness maps, -1 if unused
+};
+
+// Packs the textures of materials into texture arrays, one array per texture size,
+// format and mip count, and gives each material an entry in a table of constants and
+// layer indices. Instances then carry an index into the table, so that instances of
+// different materials whose textures share an array can be drawn with one draw call and
+// no texture rebinds.
+//
+// A material can be packed once all of its textures have loaded, as long as they all fit
+// the same array. Streamed textures are never packed as they have no fixed size. Packed
+// textures become views of their array layer, so packing does not hold them twice, and
+// free the layer when they are destroyed or reloaded.
+class material_packer
+{
+public:
+    // The array of materials that use no textures at all.
+    static constexpr std::size_t NO_ARRAY = std::numeric_limits<std::size_t>::max();
+
+    struct packed_material
+    {
+        std::size_t   array; // An index into the arrays, or NO_ARRAY
+        std::uint32_t index; // Into the packed material table
+    };
+
+private:
+    spkt::asset_manager* d_asset_manager;
+
+    using array_key = std::tuple<int, int, texture_format, int>; // Width, height, format, levels
+    std::vector<std::unique_ptr<spkt::texture_array>> d_arrays;
+    std::map<array_key, std::size_t>                  d_array_lookup;
+
+    // The array and layer that each texture has been copied into. Only valid while the
+    // array still holds the texture in that layer, as textures free their layer when they
+    // are destroyed and another texture may reuse the address.
+    std::unordered_map<const spkt::texture*, std::pair<std::size_t, int>> d_layers;
+
+    // Materials are repacked if they are edited, or if a layer of their array was freed
+    // since they were packed, so a copy of each is kept to compare against. An empty
+    // result means the material cannot be packed.
+    struct entry
+    {
+        spkt::material                 material;
+        std::optional<packed_material> packed;
+        std::uint32_t                  generation = 0; // Of the array when packed
+    };
+    std::unordered_map<const spkt::material*, entry> d_materials;
+
+    std::vector<packed_material_data> d_table;
+    std::vector<std::uint32_t>        d_free_slots; // Table entries of materials that became unpackable
+    std::uint32_t                     d_table_buffer = 0;
+    bool                              d_table_dirty = false;
+
+    // False if a layer of the material's array has been freed since it was packed, in
+    // which case its layers may now hold other textures.
+    bool is_current(const entry& e) const;
+
+    // Returns the layer of the texture in the given array, adding it if needed.
+    int layer(std::size_t array, spkt::texture& tex);
+
+    // Copies the given textures, which may be null for unused maps, into one array and
+    // returns the array with the layer of each. Returns nullopt if they do not fit one.
+    std::optional<std::pair<std::size_t, glm::ivec4>> pack_textures(
+        const std::array<spkt::texture*, 4>& textures);
+
+    material_packer(const material_packer&) = delete;
+    material_packer& operator=(const material_packer&) = delete;
+
+public:
+    material_packer(spkt::asset_manager* asset_manager);
+    ~material_packer();
+
+    // Returns where the material is packed, packing it if needed, or nullopt if it cannot
+    // be packed yet, in which case it should be drawn with its own textures.
+    std::optional<packed_material> pack(const spkt::material& material);
+
+    // Uploads any new table entries and binds the table for drawing.
+    void bind_table();
+
+    const spkt::texture_array& array(std::size_t index) const { return *d_arrays[index]; }
+    std::size_t array_count() const { return d_arrays.size(); }
+    std::size_t material_count() const { return d_table.size() - d_free_slots.size(); }
+};
+
+}
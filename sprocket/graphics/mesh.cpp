@@ -6,7 +6,9 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #include <ranges>
 
 namespace spkt {
@@ -220,7 +222,20 @@ void load_skeleton(
 static_mesh::static_mesh(const static_mesh_data& data)
     : d_vertices(data.vertices)
     , d_indices(data.indices)
+    , d_bounding_radius(0.0f)
+    , d_uv_extent(1.0f)
 {
+    glm::vec2 uv_min{std::numeric_limits<float>::max()};
+    glm::vec2 uv_max{std::numeric_limits<float>::lowest()};
+    for (const auto& vertex : data.vertices) {
+        d_bounding_radius = std::max(d_bounding_radius, glm::length(vertex.position));
+        uv_min = glm::min(uv_min, vertex.textureCoords);
+        uv_max = glm::max(uv_max, vertex.textureCoords);
+    }
+    if (!data.vertices.empty()) {
+        const glm::vec2 span = uv_max - uv_min;
+        d_uv_extent = std::max({span.x, span.y, 0.01f});
+    }
 }
 
 static_mesh_data static_mesh::load(const std::string& file)
@@ -32,6 +32,13 @@ class static_mesh
     spkt::vertex_buffer<spkt::static_vertex> d_vertices;
     spkt::index_buffer<std::uint32_t>        d_indices;
 
+    // Radius of a sphere about the model origin containing every vertex.
+    float d_bounding_radius;
+
+    // The largest span of texture coordinates across the mesh, so the number of times its
+    // textures repeat across the bounding sphere.
+    float d_uv_extent;
+
     static_mesh(const static_mesh&) = delete;
     static_mesh& operator=(const static_mesh&) = delete;
 
@@ -42,6 +49,8 @@ public:
     static static_mesh_data load(const std::string& file);
 
     std::size_t vertex_count() const { return d_indices.size(); }
+    float bounding_radius() const { return d_bounding_radius; }
+    float uv_extent() const { return d_uv_extent; }
     void bind() const;
 };
 
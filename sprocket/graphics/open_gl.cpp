@@ -1,8 +1,11 @@
 #include "open_gl.h"
 
+#include <sprocket/graphics/render_stats.h>
+
 #include <glad/glad.h>
 
 #include <concepts>
+#include <vector>
 
 namespace spkt {
 namespace {
@@ -14,16 +17,22 @@ concept bindable = requires(T t)
     { t.vertex_count() } -> std::same_as<std::size_t>;
 };
 
-template <bindable T>
-void draw_impl(const T& mesh, spkt::vertex_buffer<model_instance>* instances)
+template <bindable T, typename Instance>
+void draw_impl(const T& mesh, spkt::vertex_buffer<Instance>* instances)
 {
     mesh.bind();
     if (instances) {
         instances->bind();
         glDrawElementsInstanced(GL_TRIANGLES, (int)mesh.vertex_count(), GL_UNSIGNED_INT, nullptr, instances->size());
+        SPKT_RECORD_RENDER_STAT(instanced_draws, 1);
+        SPKT_RECORD_RENDER_STAT(instances, instances->size());
+        SPKT_RECORD_RENDER_STAT(triangles, mesh.vertex_count() / 3 * instances->size());
     } else {
         glDrawElements(GL_TRIANGLES, (int)mesh.vertex_count(), GL_UNSIGNED_INT, nullptr);
+        SPKT_RECORD_RENDER_STAT(instances, 1);
+        SPKT_RECORD_RENDER_STAT(triangles, mesh.vertex_count() / 3);
     }
+    SPKT_RECORD_RENDER_STAT(draw_calls, 1);
 }
 
 }
@@ -38,4 +47,38 @@ void draw(const spkt::animated_mesh& mesh, spkt::vertex_buffer<model_instance>*
     draw_impl(mesh, instances);
 }
 
-}
\ No newline at end of file
+void draw(const spkt::static_mesh& mesh, spkt::vertex_buffer<packed_model_instance>* instances)
+{
+    draw_impl(mesh, instances);
+}
+
+void draw(
+    const spkt::static_mesh& mesh,
+    const spkt::streaming_buffer<model_instance>& instances,
+    std::size_t first,
+    std::size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    mesh.bind();
+    instances.bind();
+    glDrawElementsInstancedBaseInstance(
+        GL_TRIANGLES, (int)mesh.vertex_count(), GL_UNSIGNED_INT, nullptr, (int)count, (GLuint)first
+    );
+    SPKT_RECORD_RENDER_STAT(instanced_draws, 1);
+    SPKT_RECORD_RENDER_STAT(instances, count);
+    SPKT_RECORD_RENDER_STAT(triangles, mesh.vertex_count() / 3 * count);
+    SPKT_RECORD_RENDER_STAT(draw_calls, 1);
+}
+
+std::vector<unsigned char> read_pixels(int width, int height)
+{
+    std::vector<unsigned char> pixels(4 * (std::size_t)width * height);
+    glFinish();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+}
@@ -5,10 +5,25 @@
 #include <sprocket/graphics/mesh.h>
 #include <sprocket/graphics/buffer.h>
 
+#include <vector>
+
 namespace spkt {
 
 void draw(const spkt::static_mesh& mesh, spkt::vertex_buffer<model_instance>* instances = nullptr);
 void draw(const spkt::animated_mesh& mesh, spkt::vertex_buffer<model_instance>* instances = nullptr);
+void draw(const spkt::static_mesh& mesh, spkt::vertex_buffer<packed_model_instance>* instances);
+
+// Draws count instances of the mesh taken from the streaming buffer starting at element first.
+void draw(
+    const spkt::static_mesh& mesh,
+    const spkt::streaming_buffer<model_instance>& instances,
+    std::size_t first,
+    std::size_t count
+);
+
+// Waits for all rendering to finish and reads back the RGBA8 pixels of the bound frame
+// buffer, bottom row first. Stalls the pipeline so is only suitable for tools and tests.
+std::vector<unsigned char> read_pixels(int width, int height);
 
 template <typename T>
 concept bindable = requires(T t)
@@ -0,0 +1,91 @@
+#include "particles.h"
+
+#include <algorithm>
+
+namespace spkt {
+namespace {
+
+// out[i] += in[i] * dt over the first count elements.
+void integrate(float* out, const float* in, float dt, std::size_t count)
+{
+    for (std::size_t i = 0; i != count; ++i) {
+        out[i] += in[i] * dt;
+    }
+}
+
+}
+
+particle_pool::particle_pool(std::size_t capacity)
+    : d_capacity(capacity)
+{
+    for (auto& s : d_streams) {
+        s.resize(capacity);
+    }
+}
+
+glm::vec3 particle_pool::get_vec3(stream x, std::size_t index) const
+{
+    return {
+        d_streams[x][index],
+        d_streams[x + 1][index],
+        d_streams[x + 2][index]
+    };
+}
+
+bool particle_pool::emit(const spkt::particle& particle)
+{
+    if (d_size == d_capacity) {
+        return false;
+    }
+
+    const std::size_t i = d_size++;
+    for (int axis = 0; axis != 3; ++axis) {
+        d_streams[POSITION_X + axis][i]     = particle.position[axis];
+        d_streams[VELOCITY_X + axis][i]     = particle.velocity[axis];
+        d_streams[ACCELERATION_X + axis][i] = particle.acceleration[axis];
+        d_streams[SCALE_X + axis][i]        = particle.scale[axis];
+    }
+    d_streams[LIFE][i] = particle.life;
+    return true;
+}
+
+void particle_pool::update(float dt)
+{
+    float* life = data(LIFE);
+    for (std::size_t i = 0; i != d_size; ++i) {
+        life[i] -= dt;
+    }
+
+    // Positions are integrated with the velocity from before this update.
+    integrate(data(POSITION_X), data(VELOCITY_X), dt, d_size);
+    integrate(data(POSITION_Y), data(VELOCITY_Y), dt, d_size);
+    integrate(data(POSITION_Z), data(VELOCITY_Z), dt, d_size);
+    integrate(data(VELOCITY_X), data(ACCELERATION_X), dt, d_size);
+    integrate(data(VELOCITY_Y), data(ACCELERATION_Y), dt, d_size);
+    integrate(data(VELOCITY_Z), data(ACCELERATION_Z), dt, d_size);
+
+    // Swap-remove dead particles. The particle moved into a freed slot has not been
+    // checked yet, so the index is not advanced.
+    std::size_t i = 0;
+    while (i < d_size) {
+        if (life[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        --d_size;
+        for (auto& s : d_streams) {
+            s[i] = s[d_size];
+        }
+    }
+}
+
+std::size_t particle_pool::write_instances(std::span<spkt::model_instance> out) const
+{
+    const std::size_t count = std::min(d_size, out.size());
+    for (std::size_t i = 0; i != count; ++i) {
+        out[i] = {position(i), {0.0, 0.0, 0.0, 1.0}, scale(i)};
+    }
+    return count;
+}
+
+}
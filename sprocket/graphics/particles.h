@@ -1,7 +1,12 @@
 #pragma once
+#include <sprocket/graphics/buffer_element_types.h>
+
 #include <glm/glm.hpp>
 
+#include <array>
 #include <cstddef>
+#include <span>
+#include <vector>
 
 namespace spkt {
 
@@ -11,9 +16,63 @@ struct particle
     glm::vec3 velocity      = {0.0, 0.0, 0.0};
     glm::vec3 acceleration  = {0.0, 0.0, 0.0};
     glm::vec3 scale         = {1.0, 1.0, 1.0};
-    double life = -1.0;
+    float life = -1.0f;
 };
 
+// The default capacity of a particle_pool.
 static constexpr std::size_t NUM_PARTICLES = 10000;
 
-}
\ No newline at end of file
+// Fixed capacity storage for particles. Each component is stored in its own float array
+// so that updates are simple loops over contiguous memory that the compiler can vectorise.
+// Live particles are kept densely packed at the front of the arrays: particles that die
+// are replaced by the last live particle, so the cost of an update is proportional to the
+// number of live particles rather than the capacity. The order of particles is therefore
+// not stable across updates.
+class particle_pool
+{
+    enum stream : std::size_t
+    {
+        POSITION_X, POSITION_Y, POSITION_Z,
+        VELOCITY_X, VELOCITY_Y, VELOCITY_Z,
+        ACCELERATION_X, ACCELERATION_Y, ACCELERATION_Z,
+        SCALE_X, SCALE_Y, SCALE_Z,
+        LIFE,
+        STREAM_COUNT
+    };
+
+    std::size_t d_capacity;
+    std::size_t d_size = 0;
+
+    std::array<std::vector<float>, STREAM_COUNT> d_streams;
+
+    float* data(stream s) { return d_streams[s].data(); }
+    const float* data(stream s) const { return d_streams[s].data(); }
+
+    glm::vec3 get_vec3(stream x, std::size_t index) const;
+
+public:
+    explicit particle_pool(std::size_t capacity = NUM_PARTICLES);
+
+    // Adds a particle if there is space. Returns false, dropping the particle, if the
+    // pool is full; live particles are never overwritten.
+    bool emit(const spkt::particle& particle);
+
+    // Integrates all live particles and removes those whose life has run out.
+    void update(float dt);
+
+    void clear() { d_size = 0; }
+
+    std::size_t size() const { return d_size; }
+    std::size_t capacity() const { return d_capacity; }
+
+    // Accessors for live particles, index must be less than size().
+    glm::vec3 position(std::size_t index) const { return get_vec3(POSITION_X, index); }
+    glm::vec3 scale(std::size_t index) const { return get_vec3(SCALE_X, index); }
+    float life(std::size_t index) const { return d_streams[LIFE][index]; }
+
+    // Writes a render instance for each live particle, up to the size of out, and returns
+    // the number written. out may be mapped GPU memory, so it is only written to.
+    std::size_t write_instances(std::span<spkt::model_instance> out) const;
+};
+
+}
@@ -0,0 +1,255 @@
+#include "pixel_buffer.h"
+
+#include <sprocket/core/log.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <utility>
+
+namespace spkt {
+namespace {
+
+// Slices are aligned for the widest texel block, and for memcpy.
+constexpr std::size_t ALIGNMENT = 64;
+
+// Freed heap buffers up to this many bytes in total are kept for reuse, so a scene's
+// worth of similarly sized images does not fault in fresh pages for each one.
+constexpr std::size_t MAX_CACHED_HEAP_BYTES = 64 * 1024 * 1024;
+
+pixel_unpack_pool* s_pool = nullptr;
+
+std::mutex                                          s_heap_mutex;
+std::vector<std::pair<unsigned char*, std::size_t>> s_heap_cache;
+std::size_t                                         s_heap_cached_bytes = 0;
+
+std::size_t align_up(std::size_t size)
+{
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Returns the smallest cached buffer that fits without wasting more than half of it, or
+// a newly allocated one.
+std::pair<unsigned char*, std::size_t> heap_allocate(std::size_t size)
+{
+    {
+        std::lock_guard lock(s_heap_mutex);
+        auto best = s_heap_cache.end();
+        for (auto it = s_heap_cache.begin(); it != s_heap_cache.end(); ++it) {
+            if (it->second >= size && it->second / 2 <= size
+                && (best == s_heap_cache.end() || it->second < best->second)) {
+                best = it;
+            }
+        }
+        if (best != s_heap_cache.end()) {
+            const auto buffer = *best;
+            s_heap_cache.erase(best);
+            s_heap_cached_bytes -= buffer.second;
+            return buffer;
+        }
+    }
+    const std::size_t capacity = align_up(size);
+    return {static_cast<unsigned char*>(::operator new(capacity, std::align_val_t{ALIGNMENT})), capacity};
+}
+
+void heap_free(unsigned char* data, std::size_t capacity)
+{
+    {
+        std::lock_guard lock(s_heap_mutex);
+        if (s_heap_cached_bytes + capacity <= MAX_CACHED_HEAP_BYTES) {
+            s_heap_cache.emplace_back(data, capacity);
+            s_heap_cached_bytes += capacity;
+            return;
+        }
+    }
+    ::operator delete(data, std::align_val_t{ALIGNMENT});
+}
+
+}
+
+pixel_unpack_pool::pixel_unpack_pool(std::size_t size)
+    : d_size(align_up(size))
+{
+    assert(!s_pool);
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &d_buffer);
+    glNamedBufferStorage(d_buffer, d_size, nullptr, flags);
+    d_mapped = static_cast<unsigned char*>(glMapNamedBufferRange(d_buffer, 0, d_size, flags));
+    if (!d_mapped) {
+        log::warn("Could not map the pixel unpack pool, textures will upload from client memory");
+        return;
+    }
+    d_free.push_back({0, d_size});
+    s_pool = this;
+}
+
+pixel_unpack_pool::~pixel_unpack_pool()
+{
+    if (s_pool == this) {
+        s_pool = nullptr;
+    }
+    for (auto& fenced : d_fenced) {
+        glDeleteSync(static_cast<GLsync>(fenced.fence));
+    }
+    if (d_mapped) {
+        glUnmapNamedBuffer(d_buffer);
+    }
+    glDeleteBuffers(1, &d_buffer);
+}
+
+pixel_unpack_pool* pixel_unpack_pool::instance()
+{
+    return s_pool;
+}
+
+bool pixel_unpack_pool::allocate(std::size_t size, std::size_t* offset)
+{
+    size = align_up(size);
+    std::lock_guard lock(d_mutex);
+    auto it = std::ranges::find_if(d_free, [&](const range& r) { return r.size >= size; });
+    if (it == d_free.end()) {
+        return false;
+    }
+    *offset = it->offset;
+    it->offset += size;
+    it->size -= size;
+    if (it->size == 0) {
+        d_free.erase(it);
+    }
+    return true;
+}
+
+void pixel_unpack_pool::release(std::size_t offset, std::size_t size)
+{
+    std::lock_guard lock(d_mutex);
+    d_released.push_back({offset, align_up(size)});
+}
+
+void pixel_unpack_pool::free_range(range r)
+{
+    auto it = std::ranges::lower_bound(d_free, r.offset, {}, &range::offset);
+    it = d_free.insert(it, r);
+    if (auto next = std::next(it); next != d_free.end() && it->offset + it->size == next->offset) {
+        it->size += next->size;
+        d_free.erase(next);
+    }
+    if (it != d_free.begin()) {
+        if (auto prev = std::prev(it); prev->offset + prev->size == it->offset) {
+            prev->size += it->size;
+            d_free.erase(it);
+        }
+    }
+}
+
+void pixel_unpack_pool::collect()
+{
+    std::lock_guard lock(d_mutex);
+    if (!d_released.empty()) {
+        d_fenced.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(d_released)});
+        d_released.clear();
+    }
+
+    // Fences signal in order, so stop at the first that has not.
+    while (!d_fenced.empty()) {
+        const auto sync = static_cast<GLsync>(d_fenced.front().fence);
+        const GLenum result = glClientWaitSync(sync, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync(sync);
+        for (const auto& r : d_fenced.front().ranges) {
+            free_range(r);
+        }
+        d_fenced.erase(d_fenced.begin());
+    }
+}
+
+pixel_buffer::~pixel_buffer()
+{
+    reset();
+}
+
+pixel_buffer::pixel_buffer(pixel_buffer&& other) noexcept
+    : d_data(std::exchange(other.d_data, nullptr))
+    , d_size(std::exchange(other.d_size, 0))
+    , d_capacity(std::exchange(other.d_capacity, 0))
+    , d_pool(std::exchange(other.d_pool, nullptr))
+    , d_offset(std::exchange(other.d_offset, 0))
+{
+}
+
+pixel_buffer& pixel_buffer::operator=(pixel_buffer&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        d_data = std::exchange(other.d_data, nullptr);
+        d_size = std::exchange(other.d_size, 0);
+        d_capacity = std::exchange(other.d_capacity, 0);
+        d_pool = std::exchange(other.d_pool, nullptr);
+        d_offset = std::exchange(other.d_offset, 0);
+    }
+    return *this;
+}
+
+void pixel_buffer::reset()
+{
+    if (!d_data) {
+        return;
+    }
+    if (d_pool) {
+        // The pool may already be gone at shutdown, taking its memory with it.
+        if (d_pool == pixel_unpack_pool::instance()) {
+            d_pool->release(d_offset, d_capacity);
+        }
+    } else {
+        heap_free(d_data, d_capacity);
+    }
+    d_data = nullptr;
+    d_size = 0;
+    d_capacity = 0;
+    d_pool = nullptr;
+}
+
+pixel_buffer pixel_buffer::allocate(std::size_t size)
+{
+    pixel_buffer buffer;
+    if (size == 0) {
+        return buffer;
+    }
+
+    buffer.d_size = size;
+    if (auto* pool = pixel_unpack_pool::instance(); pool && pool->allocate(size, &buffer.d_offset)) {
+        buffer.d_pool = pool;
+        buffer.d_data = pool->mapped() + buffer.d_offset;
+        buffer.d_capacity = align_up(size);
+    } else {
+        std::tie(buffer.d_data, buffer.d_capacity) = heap_allocate(size);
+    }
+    return buffer;
+}
+
+pixel_buffer pixel_buffer::copy_of(std::span<const unsigned char> bytes)
+{
+    auto buffer = allocate(bytes.size());
+    if (!bytes.empty()) {
+        std::memcpy(buffer.data(), bytes.data(), bytes.size());
+    }
+    return buffer;
+}
+
+std::uint32_t pixel_buffer::unpack_buffer() const
+{
+    return d_pool ? d_pool->buffer() : 0;
+}
+
+const unsigned char* pixel_buffer::source() const
+{
+    return d_pool ? reinterpret_cast<const unsigned char*>(d_offset) : d_data;
+}
+
+}
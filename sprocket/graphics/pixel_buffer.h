@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace spkt {
+
+// A pool of persistently mapped GL_PIXEL_UNPACK_BUFFER memory. Texture decoders on the
+// asset loading threads write their output straight into slices of it, so uploading is
+// an asynchronous copy on the GPU rather than a synchronous copy out of client memory.
+// A released slice is only reused once the GPU has finished reading from it.
+//
+// The pool must be created and destroyed on the thread with the OpenGL context, and is
+// owned by the application, which should declare it before its asset manager so that it
+// outlives any loads still in flight. While there is no pool, or it is full, decoders
+// fall back to heap memory.
+class pixel_unpack_pool
+{
+public:
+    static constexpr std::size_t DEFAULT_SIZE = 128 * 1024 * 1024;
+
+private:
+    struct range
+    {
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    struct fenced_ranges
+    {
+        void*              fence;
+        std::vector<range> ranges;
+    };
+
+    std::uint32_t  d_buffer = 0;
+    unsigned char* d_mapped = nullptr;
+    std::size_t    d_size;
+
+    // Guards the lists below, as slices are allocated on the loading threads.
+    mutable std::mutex d_mutex;
+
+    std::vector<range>         d_free;     // Sorted by offset, adjacent ranges merged
+    std::vector<range>         d_released; // Released since the last collect()
+    std::vector<fenced_ranges> d_fenced;   // Waiting on the GPU, oldest first
+
+    void free_range(range r);
+
+    pixel_unpack_pool(const pixel_unpack_pool&) = delete;
+    pixel_unpack_pool& operator=(const pixel_unpack_pool&) = delete;
+
+public:
+    explicit pixel_unpack_pool(std::size_t size = DEFAULT_SIZE);
+    ~pixel_unpack_pool();
+
+    // The live pool, or nullptr if there is none.
+    static pixel_unpack_pool* instance();
+
+    // Returns the offset of a free slice of at least size bytes, or false if there is no
+    // room. Thread safe.
+    bool allocate(std::size_t size, std::size_t* offset);
+
+    // Returns a slice to the pool once the GPU commands issued so far are done with it.
+    // Thread safe, and makes no OpenGL calls.
+    void release(std::size_t offset, std::size_t size);
+
+    // Fences the slices released since the last call and recycles the slices whose
+    // fences have signalled. Called on the OpenGL thread at the end of every frame.
+    void collect();
+
+    std::uint32_t buffer() const { return d_buffer; }
+    unsigned char* mapped() const { return d_mapped; }
+};
+
+// Storage for decoded texture pixels, allocated so that decoders can write straight into
+// it. It lives in a slice of the pixel_unpack_pool when there is room, and otherwise in
+// aligned heap memory which is recycled between loads rather than freed.
+class pixel_buffer
+{
+    unsigned char* d_data = nullptr;
+    std::size_t    d_size = 0;
+    std::size_t    d_capacity = 0;
+
+    // Set when the pixels are in the pool, at the given offset into its buffer.
+    pixel_unpack_pool* d_pool = nullptr;
+    std::size_t        d_offset = 0;
+
+    void reset();
+
+public:
+    pixel_buffer() = default;
+    ~pixel_buffer();
+
+    pixel_buffer(pixel_buffer&& other) noexcept;
+    pixel_buffer& operator=(pixel_buffer&& other) noexcept;
+
+    pixel_buffer(const pixel_buffer&) = delete;
+    pixel_buffer& operator=(const pixel_buffer&) = delete;
+
+    // The capacity may be larger than the size, but never smaller.
+    static pixel_buffer allocate(std::size_t size);
+    static pixel_buffer copy_of(std::span<const unsigned char> bytes);
+
+    unsigned char* data() { return d_data; }
+    const unsigned char* data() const { return d_data; }
+    std::size_t size() const { return d_size; }
+    std::size_t capacity() const { return d_capacity; }
+    bool empty() const { return d_size == 0; }
+    std::span<const unsigned char> span() const { return {d_data, d_size}; }
+
+    // The unpack buffer holding the pixels and their offset within it, or 0 if they are
+    // in client memory. Uploads should bind the buffer and pass source() as the pointer.
+    std::uint32_t unpack_buffer() const;
+    const unsigned char* source() const;
+};
+
+}
@@ -1,21 +1,20 @@
 #include "post_processor.h"
 
+#include <sprocket/graphics/gpu_profiler.h>
 #include <sprocket/graphics/mesh.h>
 #include <sprocket/graphics/texture.h>
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cassert>
+#include <format>
 #include <string>
-#include <ranges>
+#include <unordered_map>
 
 namespace spkt {
 namespace {
 
-auto ignore_last(int n)
-{
-    return std::views::reverse | std::views::drop(n) | std::views::reverse;
-}
-
 static_mesh_data quad_mesh_data()
 {
     return {
@@ -31,56 +30,153 @@ static_mesh_data quad_mesh_data()
 
 }
 
+spkt::frame_buffer_ptr render_target_pool::acquire(int width, int height)
+{
+    if (auto it = d_free.find({width, height}); it != d_free.end() && !it->second.empty()) {
+        auto target = std::move(it->second.back());
+        it->second.pop_back();
+        return target;
+    }
+    return std::make_unique<frame_buffer>(width, height);
+}
+
+void render_target_pool::release(spkt::frame_buffer_ptr target)
+{
+    d_free[{target->width(), target->height()}].push_back(std::move(target));
+}
+
 post_processor::post_processor(int width, int height)
     : d_quad(std::make_unique<static_mesh>(quad_mesh_data()))
-    , d_target(std::make_unique<frame_buffer>(width, height))
-    , d_source(std::make_unique<frame_buffer>(width, height))
-    , d_effects()
+    , d_scene(std::make_unique<frame_buffer>(width, height))
+    , d_pool()
+    , d_passes()
+    , d_width(width)
+    , d_height(height)
 {}
 
+void post_processor::add_pass(const post_pass_desc& desc)
+{
+    assert(!desc.inputs.empty());
+    d_passes.push_back({desc, {}, nullptr});
+}
+
 void post_processor::add_effect(
     std::string_view vertex_shader,
-    std::string_view fragment_shader)
+    std::string_view fragment_shader,
+    float resolution_scale)
+{
+    const std::string input = d_passes.empty() ? std::string{POST_SCENE} : d_passes.back().desc.output;
+    add_pass({
+        .output = std::format("effect_{}", d_passes.size()),
+        .inputs = {input},
+        .vertex_shader = std::string{vertex_shader},
+        .fragment_shader = std::string{fragment_shader},
+        .resolution_scale = resolution_scale
+    });
+}
+
+void post_processor::add_colour_transform(std::string_view function)
 {
-    d_effects.push_back(std::make_unique<shader>(vertex_shader, fragment_shader));
+    if (d_passes.empty()) {
+        add_effect("resources/Shaders/Post_Copy.vert", "resources/Shaders/Post_Copy.frag");
+    }
+
+    auto& pass = d_passes.back();
+    assert(pass.colour_transforms.size() < MAX_COLOUR_TRANSFORMS);
+    pass.colour_transforms.push_back(std::string{function});
+    pass.shader = nullptr;
 }
 
 void post_processor::start_frame()
 {
-    d_target->bind();
+    d_scene->bind();
 }
 
 void post_processor::end_frame()
 {
-    assert(d_effects.size() > 0);
+    assert(d_passes.size() > 0);
+    spkt::gpu_scope scope("post_processing");
+    d_scene->unbind();
     d_quad->bind();
 
-    // Apply all effects except for the last.
-    for (auto& effect : d_effects | ignore_last(1)) {
-        effect->bind();
-        effect->load("target_width", d_target->width());
-        effect->load("target_height", d_target->height());
+    // Transient outputs are returned to the pool after the last pass that reads them.
+    std::unordered_map<std::string, std::size_t> last_use;
+    for (std::size_t i = 0; i != d_passes.size(); ++i) {
+        for (const auto& input : d_passes[i].desc.inputs) {
+            last_use[input] = i;
+        }
+    }
+
+    std::unordered_map<std::string, frame_buffer_ptr> outputs;
+    const auto input_texture = [&](const std::string& name) -> const texture& {
+        return name == POST_SCENE ? d_scene->colour_texture() : outputs.at(name)->colour_texture();
+    };
+
+    for (std::size_t i = 0; i != d_passes.size(); ++i) {
+        auto& pass = d_passes[i];
+        spkt::gpu_scope pass_scope(pass.desc.output);
+        if (!pass.shader) {
+            shader_defines defines;
+            for (std::size_t j = 0; j != pass.colour_transforms.size(); ++j) {
+                defines.push_back(std::format("COLOUR_TRANSFORM_{} {}", j, pass.colour_transforms[j]));
+            }
+            pass.shader = std::make_unique<shader>(pass.desc.vertex_shader, pass.desc.fragment_shader, defines);
+        }
+
+        pass.shader->bind();
+        for (std::size_t slot = 0; slot != pass.desc.inputs.size(); ++slot) {
+            input_texture(pass.desc.inputs[slot]).bind((int)slot);
+        }
+
+        // Effects offset their samples by texels of their input, which may not be the
+        // same size as their output.
+        const auto& source = input_texture(pass.desc.inputs.front());
+        pass.shader->load("target_width", source.width());
+        pass.shader->load("target_height", source.height());
+
+        // The final pass draws to the screen, regardless of its resolution scale.
+        frame_buffer_ptr target;
+        if (i + 1 == d_passes.size()) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        } else {
+            const int width = std::max(1, (int)(d_width * pass.desc.resolution_scale));
+            const int height = std::max(1, (int)(d_height * pass.desc.resolution_scale));
+            target = d_pool.acquire(width, height);
+            target->bind();
+        }
 
-        std::swap(d_target, d_source); // Previous render becomes the source
-        d_source->colour_texture().bind(0);
-        d_target->bind();
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+
+        if (target) {
+            target->unbind();
+        }
+
+        for (const auto& input : pass.desc.inputs) {
+            if (last_use[input] == i) {
+                if (auto it = outputs.find(input); it != outputs.end()) {
+                    d_pool.release(std::move(it->second));
+                    outputs.erase(it);
+                }
+            }
+        }
+
+        if (target) {
+            outputs[pass.desc.output] = std::move(target);
+        }
     }
 
-    // Finally, apply the last effect to render to the screen
-    d_effects.back()->bind();
-    d_effects.back()->load("target_width", d_target->width());
-    d_effects.back()->load("target_height", d_target->height());
-    
-    d_target->colour_texture().bind(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+    // Outputs that no later pass read.
+    for (auto& [name, target] : outputs) {
+        d_pool.release(std::move(target));
+    }
 }
 
 void post_processor::set_screen_size(int width, int height)
 {
-    d_target->resize(width, height);
-    d_source->resize(width, height);
+    d_scene->resize(width, height);
+    d_pool.clear();
+    d_width = width;
+    d_height = height;
 }
     
 }
\ No newline at end of file
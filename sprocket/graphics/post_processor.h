@@ -2,30 +2,93 @@
 #include <sprocket/graphics/frame_buffer.h>
 #include <sprocket/graphics/mesh.h>
 #include <sprocket/graphics/shader.h>
+#include <sprocket/utility/hashing.h>
 
+#include <cstddef>
+#include <string>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace spkt {
 
+// Name of the input that refers to the frame rendered between start_frame and end_frame.
+inline constexpr std::string_view POST_SCENE = "scene";
+
+// Must match the number of COLOUR_TRANSFORM_N slots in Post_Output.glsl
+static constexpr std::size_t MAX_COLOUR_TRANSFORMS = 4;
+
+// A full screen pass in the post processing graph. Each input names the scene or the
+// output of an earlier pass and is bound to the texture slot matching its index, so
+// fragment shaders should use layout(binding = N) for anything but the first. The pass
+// renders at resolution_scale times the screen size, except for the final pass, which
+// always renders to the screen.
+struct post_pass_desc
+{
+    std::string              output;
+    std::vector<std::string> inputs;
+    std::string              vertex_shader;
+    std::string              fragment_shader;
+    float                    resolution_scale = 1.0f;
+};
+
+// Hands out frame buffers for the transient outputs of post processing passes. Released
+// buffers are kept and reused by later passes, or later frames, that need the same size.
+class render_target_pool
+{
+    // Keyed by (width, height). Frame buffers currently only have one colour format, so
+    // the size is all that distinguishes them.
+    std::unordered_map<std::pair<int, int>, std::vector<spkt::frame_buffer_ptr>, spkt::hash_pair> d_free;
+
+public:
+    spkt::frame_buffer_ptr acquire(int width, int height);
+    void release(spkt::frame_buffer_ptr target);
+
+    // Frees all pooled buffers, for example after the screen has been resized.
+    void clear() { d_free.clear(); }
+};
+
 class post_processor
 {
+    struct pass
+    {
+        post_pass_desc           desc;
+        std::vector<std::string> colour_transforms;
+        spkt::shader_ptr         shader; // Built on first use
+    };
+
     // The quad that is written to the frame buffer when applying the affect,
     // should mostly always match the size of the screen.
     spkt::static_mesh_ptr d_quad;
 
-    // Post-processing uses two frame buffers. When applying an effect, we write
-    // the texture from the source to the target frame buffer via the effect shader.
-    spkt::frame_buffer_ptr d_target;
-    spkt::frame_buffer_ptr d_source;
+    // The scene is rendered into this, and is the input of the first pass.
+    spkt::frame_buffer_ptr d_scene;
 
-    std::vector<spkt::shader_ptr> d_effects;
+    spkt::render_target_pool d_pool;
+    std::vector<pass>        d_passes;
+
+    int d_width;
+    int d_height;
 
 public:
     post_processor(int width, int height);
 
-    // Appends a post process effect to the end of the process pipeline.
-    void add_effect(std::string_view vertex_shader, std::string_view fragment_shader);
+    // Appends a pass to the end of the graph.
+    void add_pass(const post_pass_desc& desc);
+
+    // Appends a post process effect that takes the output of the previous effect, or the
+    // scene if this is the first, as its only input.
+    void add_effect(
+        std::string_view vertex_shader,
+        std::string_view fragment_shader,
+        float resolution_scale = 1.0f
+    );
+
+    // Appends a per-pixel colour transform, which is the name of a vec4 -> vec4 function in
+    // Colour_Transforms.glsl. Rather than running as its own pass, it is fused into the
+    // output of the last pass; if there are no passes, a copy pass is added for it.
+    void add_colour_transform(std::string_view function);
 
     // All rendering that the effects should be applied to should be done between these
     // two function calls. end_frame will then render the result to the screen.
@@ -36,4 +99,4 @@ public:
     void set_screen_size(int width, int height);
 };
 
-}
\ No newline at end of file
+}
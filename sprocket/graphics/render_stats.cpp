@@ -0,0 +1,66 @@
+#include "render_stats.h"
+
+#include <sprocket/core/log.h>
+
+#include <format>
+#include <fstream>
+#include <string>
+
+namespace spkt {
+namespace {
+
+render_stats  s_current;
+render_stats  s_last;
+std::ofstream s_csv;
+
+}
+
+const render_stats& last_frame_render_stats()
+{
+    return s_last;
+}
+
+void end_render_stats_frame()
+{
+    s_last = s_current;
+    s_current = {};
+
+    if (s_csv.is_open()) {
+        s_csv << std::format(
+            "{},{},{},{},{},{},{},{}\n",
+            s_last.draw_calls, s_last.instanced_draws, s_last.instances, s_last.triangles,
+            s_last.shader_binds, s_last.texture_binds, s_last.uniform_uploads, s_last.buffer_bytes
+        );
+    }
+}
+
+void set_render_stats_csv(const std::string& file)
+{
+    s_csv.close();
+    if (file.empty()) {
+        return;
+    }
+
+#ifndef SPKT_RENDER_STATS
+    log::warn("Render stats are compiled out, {} will only contain zeros", file);
+#endif
+
+    s_csv.open(file);
+    if (!s_csv) {
+        log::error("Could not open render stats file {}", file);
+        return;
+    }
+    s_csv << "draw_calls,instanced_draws,instances,triangles,"
+             "shader_binds,texture_binds,uniform_uploads,buffer_bytes\n";
+}
+
+namespace detail {
+
+render_stats& current_render_stats()
+{
+    return s_current;
+}
+
+}
+
+}
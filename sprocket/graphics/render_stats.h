@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Render statistics are collected when SPKT_RENDER_STATS is defined, which is controlled
+// by the SPROCKET_RENDER_STATS CMake option. When it is not defined, recording compiles
+// away entirely and the queries below report zeros.
+
+namespace spkt {
+
+struct render_stats
+{
+    std::uint64_t draw_calls      = 0;
+    std::uint64_t instanced_draws = 0;
+    std::uint64_t instances       = 0;
+    std::uint64_t triangles       = 0;
+    std::uint64_t shader_binds    = 0;
+    std::uint64_t texture_binds   = 0;
+    std::uint64_t uniform_uploads = 0;
+    std::uint64_t buffer_bytes    = 0; // Bytes uploaded to buffers
+};
+
+// The statistics of the last completed frame.
+const render_stats& last_frame_render_stats();
+
+// Completes the current frame: its statistics become the last frame's, are appended to
+// the CSV file if one is open, and the counters are reset. Called by spkt::run.
+void end_render_stats_frame();
+
+// Starts writing one row of statistics per frame to the given file. An empty path stops
+// writing.
+void set_render_stats_csv(const std::string& file);
+
+namespace detail {
+
+// The statistics of the frame in progress, for the recording macro.
+render_stats& current_render_stats();
+
+}
+
+}
+
+#ifdef SPKT_RENDER_STATS
+#define SPKT_RECORD_RENDER_STAT(stat, amount) (::spkt::detail::current_render_stats().stat += (amount))
+#else
+#define SPKT_RECORD_RENDER_STAT(stat, amount) ((void)0)
+#endif
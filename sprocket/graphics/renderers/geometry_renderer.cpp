@@ -10,7 +10,7 @@
 namespace spkt {
 
 geometry_renderer::geometry_renderer()
-    : d_shader("Resources/Shaders/Collider.vert", "Resources/Shaders/Collider.frag")
+    : d_shader("resources/Shaders/Collider.vert", "resources/Shaders/Collider.frag")
 {
 }
 
@@ -28,22 +28,22 @@ void geometry_renderer::end_frame() const
 
 void geometry_renderer::draw_box(const glm::mat4& transform, const glm::vec3& half_extents) const
 {
-    static const static_mesh s_cube{"Resources/Models/Cube.obj"};
+    static const static_mesh s_cube{"resources/Models/Cube.obj"};
     d_shader.load("u_model_matrix", glm::scale(transform, half_extents));
     spkt::draw(s_cube);
 }
 
 void geometry_renderer::draw_sphere(const glm::mat4& transform, const float radius) const
 {
-    static const static_mesh s_sphere{"Resources/Models/LowPolySphere.obj"};
+    static const static_mesh s_sphere{"resources/Models/LowPolySphere.obj"};
     d_shader.load("u_model_matrix", glm::scale(transform, {radius, radius, radius}));
     spkt::draw(s_sphere);
 }
 
 void geometry_renderer::draw_capsule(const glm::mat4& base_transform, const float radius, const float height) const
 {
-    static const static_mesh s_hemisphere{"Resources/Models/Hemisphere.obj"};
-    static const static_mesh s_cylinder{"Resources/Models/Cylinder.obj"};
+    static const static_mesh s_hemisphere{"resources/Models/Hemisphere.obj"};
+    static const static_mesh s_cylinder{"resources/Models/Cylinder.obj"};
 
     {  // Top Hemisphere
         auto transform = glm::translate(base_transform, {0.0, height/2, 0.0});
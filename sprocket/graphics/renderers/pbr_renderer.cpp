@@ -3,16 +3,30 @@
 #include <sprocket/graphics/asset_manager.h>
 #include <sprocket/graphics/buffer.h>
 #include <sprocket/graphics/camera.h>
+#include <sprocket/graphics/gpu_profiler.h>
 #include <sprocket/graphics/open_gl.h>
+#include <sprocket/graphics/particles.h>
 #include <sprocket/graphics/render_context.h>
+#include <sprocket/graphics/viewport.h>
 #include <sprocket/utility/hashing.h>
 #include <sprocket/utility/maths.h>
 #include <sprocket/utility/views.h>
 
+#include <glad/glad.h>
+
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -26,114 +40,389 @@ std::array<glm::mat4, MAX_BONES> default_bone_transform() {
     return arr;
 };
 
+// What each material_feature enables: the shader define, and the sampler the texture is
+// bound to. Entry i is the feature with bit i set, which shader_variants relies on when it
+// maps key bits to defines.
+struct pbr_feature
+{
+    std::uint32_t    feature;
+    std::string_view define;
+    std::string_view sampler;
+    int              slot;
+};
+
+constexpr std::array<pbr_feature, 4> PBR_FEATURES = {{
+    {MATERIAL_ALBEDO_MAP,    "USE_ALBEDO_MAP",    "u_albedo_map",    ALBEDO_SLOT},
+    {MATERIAL_NORMAL_MAP,    "USE_NORMAL_MAP",    "u_normal_map",    NORMAL_SLOT},
+    {MATERIAL_METALLIC_MAP,  "USE_METALLIC_MAP",  "u_metallic_map",  METALLIC_SLOT},
+    {MATERIAL_ROUGHNESS_MAP, "USE_ROUGHNESS_MAP", "u_roughness_map", ROUGHNESS_SLOT}
+}};
+
+constexpr const pbr_feature& pbr_feature_of(material_feature feature)
+{
+    return PBR_FEATURES[std::countr_zero(static_cast<std::uint32_t>(feature))];
+}
+
+// The defines compiled into the variant for a material key, in the order shader_variants
+// adds them, and the texture slots that upload_material binds for it as a bitmask.
+struct pbr_variant_inputs
+{
+    std::array<std::string_view, PBR_FEATURES.size()> defines = {};
+    std::uint32_t bound_slots = 0;
+
+    constexpr bool operator==(const pbr_variant_inputs&) const = default;
+};
+
+constexpr pbr_variant_inputs variant_inputs(std::uint32_t key)
+{
+    pbr_variant_inputs inputs;
+    std::size_t count = 0;
+    for (std::size_t bit = 0; bit != PBR_FEATURES.size(); ++bit) {
+        if (key & (1u << bit)) {
+            inputs.defines[count++] = PBR_FEATURES[bit].define;
+        }
+    }
+    for (const auto& feature : PBR_FEATURES) {
+        if (key & feature.feature) {
+            inputs.bound_slots |= 1u << feature.slot;
+        }
+    }
+    return inputs;
+}
+
+// Every combination of material flags must select its own variant, compiled with exactly
+// the defines of its features and binding exactly the textures of its features.
+constexpr bool pbr_variants_are_distinct()
+{
+    constexpr std::uint32_t reserved_slots = (1u << SHADOW_MAP_SLOT) | (1u << MATERIAL_LAYERS_SLOT);
+    for (std::size_t bit = 0; bit != PBR_FEATURES.size(); ++bit) {
+        if (PBR_FEATURES[bit].feature != 1u << bit) { return false; }
+        if ((1u << PBR_FEATURES[bit].slot) & reserved_slots) { return false; }
+    }
+
+    std::array<std::uint32_t, 16> keys = {};
+    for (std::uint32_t flags = 0; flags != 16; ++flags) {
+        keys[flags] = make_material_features(flags & 1, flags & 2, flags & 4, flags & 8);
+    }
+
+    for (std::uint32_t a = 0; a != 16; ++a) {
+        const auto inputs = variant_inputs(keys[a]);
+        std::size_t num_defines = 0;
+        for (std::size_t bit = 0; bit != PBR_FEATURES.size(); ++bit) {
+            const auto& feature = PBR_FEATURES[bit];
+            const bool used = (a >> bit) & 1;
+            const bool defined = std::ranges::find(inputs.defines, feature.define) != inputs.defines.end();
+            const bool bound = inputs.bound_slots & (1u << feature.slot);
+            if (used != defined || used != bound) { return false; }
+            num_defines += used;
+        }
+        if (std::popcount(inputs.bound_slots) != (int)num_defines) { return false; }
+
+        for (std::uint32_t b = 0; b != a; ++b) {
+            const auto other = variant_inputs(keys[b]);
+            if (keys[a] == keys[b] || inputs.defines == other.defines || inputs.bound_slots == other.bound_slots) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(pbr_variants_are_distinct());
+
+// Binds only the textures that the material's pipeline samples from, and loads the
+// constants for the inputs that are not textured.
 void upload_material(
     const shader& shader,
     const material& material,
     asset_manager* assetManager
 )
 {
-    assetManager->get<texture>(material.albedoMap).bind(ALBEDO_SLOT);
-    assetManager->get<texture>(material.normalMap).bind(NORMAL_SLOT);
-    assetManager->get<texture>(material.metallicMap).bind(METALLIC_SLOT);
-    assetManager->get<texture>(material.roughnessMap).bind(ROUGHNESS_SLOT);
+    const std::uint32_t features = material.features();
 
-    shader.load("u_use_albedo_map", material.useAlbedoMap ? 1.0f : 0.0f);
-    shader.load("u_use_normal_map", material.useNormalMap ? 1.0f : 0.0f);
-    shader.load("u_use_metallic_map", material.useMetallicMap ? 1.0f : 0.0f);
-    shader.load("u_use_roughness_map", material.useRoughnessMap ? 1.0f : 0.0f);
+    if (features & MATERIAL_ALBEDO_MAP) {
+        assetManager->get<texture>(material.albedoMap).bind(pbr_feature_of(MATERIAL_ALBEDO_MAP).slot);
+    } else {
+        shader.load("u_albedo", material.albedo);
+    }
+
+    if (features & MATERIAL_NORMAL_MAP) {
+        assetManager->get<texture>(material.normalMap).bind(pbr_feature_of(MATERIAL_NORMAL_MAP).slot);
+    }
+
+    if (features & MATERIAL_METALLIC_MAP) {
+        assetManager->get<texture>(material.metallicMap).bind(pbr_feature_of(MATERIAL_METALLIC_MAP).slot);
+    } else {
+        shader.load("u_metallic", material.metallic);
+    }
+
+    if (features & MATERIAL_ROUGHNESS_MAP) {
+        assetManager->get<texture>(material.roughnessMap).bind(pbr_feature_of(MATERIAL_ROUGHNESS_MAP).slot);
+    } else {
+        shader.load("u_roughness", material.roughness);
+    }
+}
+
+// The largest on-screen size in pixels of one unit of UV space across the instances of a
+// mesh, from the size of its bounding sphere at the distance of each instance and the
+// span of its texture coordinates.
+float uv_screen_size(
+    const static_mesh& mesh,
+    const std::vector<model_instance>& instances,
+    const glm::vec3& camera_position,
+    float pixels_per_unit)
+{
+    float size = 0.0f;
+    for (const auto& instance : instances) {
+        const glm::vec3 scale = glm::abs(instance.scale);
+        const float radius = mesh.bounding_radius() * std::max({scale.x, scale.y, scale.z});
+        const float distance = std::max(glm::length(instance.position - camera_position), radius);
+        if (distance > 0.0f) {
+            size = std::max(size, 2.0f * radius * pixels_per_unit / distance);
+        }
+    }
+    return size / mesh.uv_extent();
+}
+
+// The material features in bit order, followed by the packed material variant.
+const std::vector<std::string> PBR_FEATURE_DEFINES = [] {
+    std::vector<std::string> defines;
+    for (const auto& feature : PBR_FEATURES) {
+        defines.emplace_back(feature.define);
+    }
+    defines.emplace_back("USE_PACKED_MATERIAL");
+    return defines;
+}();
+
+// Reads the material of each instance from the packed material table instead.
+constexpr std::uint32_t PACKED_MATERIAL_VARIANT = 1 << 4;
 
-    shader.load("u_albedo", material.albedo);
-    shader.load("u_roughness", material.roughness);
-    shader.load("u_metallic", material.metallic);
+void load_sampler_slots(spkt::shader& shader)
+{
+    for (const auto& feature : PBR_FEATURES) {
+        shader.load(std::string(feature.sampler), feature.slot);
+    }
+    shader.load("shadow_map", SHADOW_MAP_SLOT);
+    shader.load("u_material_layers", MATERIAL_LAYERS_SLOT);
 }
 
 }
 
+void static_mesh_bucket::add(
+    const glm::vec3& position, const glm::quat& orientation, const glm::vec3& scale,
+    const std::string& mesh, const std::string& material)
+{
+    commands[{mesh, material}].push_back({position, orientation, scale});
+}
+
+void static_mesh_bucket::merge(static_mesh_bucket&& other)
+{
+    if (commands.empty()) {
+        commands = std::move(other.commands);
+        return;
+    }
+
+    for (auto& [key, instances] : other.commands) {
+        auto& target = commands[key];
+        if (target.empty()) {
+            target = std::move(instances);
+        } else {
+            target.insert(target.end(), instances.begin(), instances.end());
+        }
+    }
+}
+
 pbr_renderer::pbr_renderer(asset_manager* asset_manager)
     : d_assetManager(asset_manager)
-    , d_staticShader("Resources/Shaders/Entity_PBR_Static.vert", "Resources/Shaders/Entity_PBR.frag")
-    , d_animatedShader("Resources/Shaders/Entity_PBR_Animated.vert", "Resources/Shaders/Entity_PBR.frag")
+    , d_static_shaders(
+        "resources/Shaders/Entity_PBR_Static.vert",
+        "resources/Shaders/Entity_PBR.frag",
+        PBR_FEATURE_DEFINES,
+        load_sampler_slots)
+    , d_animated_shaders(
+        "resources/Shaders/Entity_PBR_Animated.vert",
+        "resources/Shaders/Entity_PBR.frag",
+        PBR_FEATURE_DEFINES,
+        load_sampler_slots)
     , d_instanceBuffer()
+    , d_material_packer(asset_manager)
+    , d_packed_instance_buffer()
+    , d_particle_instances(spkt::NUM_PARTICLES)
 {
-    d_staticShader.load("u_albedo_map", ALBEDO_SLOT);
-    d_staticShader.load("u_normal_map", NORMAL_SLOT);
-    d_staticShader.load("u_metallic_map", METALLIC_SLOT);
-    d_staticShader.load("u_roughness_map", ROUGHNESS_SLOT);
-    d_staticShader.load("shadow_map", SHADOW_MAP_SLOT);
-
-    d_animatedShader.load("u_albedo_map", ALBEDO_SLOT);
-    d_animatedShader.load("u_normal_map", NORMAL_SLOT);
-    d_animatedShader.load("u_metallic_map", METALLIC_SLOT);
-    d_animatedShader.load("u_roughness_map", ROUGHNESS_SLOT);
-    d_animatedShader.load("shadow_map", SHADOW_MAP_SLOT);
 }
 
-void pbr_renderer::enable_shadows(const shadow_map& shadowMap)
+spkt::shader& pbr_renderer::bind_variant(spkt::shader_variants& variants, std::uint32_t features)
 {
-    d_staticShader.load("u_light_proj_view", shadowMap.get_light_proj_view());
-    d_animatedShader.load("u_light_proj_view", shadowMap.get_light_proj_view());
-    shadowMap.get_texture().bind(SHADOW_MAP_SLOT);
+    assert(d_frame_data);
+    auto& shader = variants.get(features);
+    shader.bind();
+    if (!d_frame_data->prepared_shaders.insert(&shader).second) {
+        return shader;
+    }
+
+    shader.load("u_proj_matrix", d_frame_data->proj);
+    shader.load("u_view_matrix", d_frame_data->view);
+    shader.load("u_cascade_proj_view", d_cascade_proj_views);
+    shader.load("u_cascade_splits", d_cascade_splits);
+    shader.load("u_cascade_count", d_cascade_count);
+
+    shader.load("u_ambience_colour", d_ambience_colour);
+    shader.load("u_ambience_brightness", d_ambience_brightness);
+
+    shader.load("u_sun_colour", d_sun_colour);
+    shader.load("u_sun_direction", d_sun_direction);
+    shader.load("u_sun_brightness", d_sun_brightness);
+
+    shader.load("u_light_pos", d_frame_data->light_positions);
+    shader.load("u_light_colour",  d_frame_data->light_colours);
+    shader.load("u_light_brightness",  d_frame_data->light_brightnesses);
+    return shader;
 }
 
-void pbr_renderer::for_each_shader(const std::function<void(spkt::shader& shader)>& callback)
+void pbr_renderer::enable_shadows(const shadow_map& shadowMap)
 {
-    callback(d_staticShader);
-    callback(d_animatedShader);
+    d_cascade_count = (int)shadowMap.cascade_count();
+    for (std::size_t i = 0; i != shadowMap.cascade_count(); ++i) {
+        d_cascade_proj_views[i] = shadowMap.cascade(i).proj_view;
+        d_cascade_splits[i] = shadowMap.cascade(i).split_depth;
+    }
+    shadowMap.bind_texture(SHADOW_MAP_SLOT);
 }
 
 void pbr_renderer::begin_frame(const glm::mat4& proj, const glm::mat4& view)
 {
     assert(!d_frame_data);
     d_frame_data = frame_data{};
-    for_each_shader([&](spkt::shader& shader) {
-        shader.bind();
-        shader.load("u_proj_matrix", proj);
-        shader.load("u_view_matrix", view);
-    });
+    d_frame_data->proj = proj;
+    d_frame_data->view = view;
+    d_frame_data->camera_position = glm::vec3(glm::inverse(view)[3]);
+
+    // proj[1][1] maps a vertical length at distance one to NDC, which spans two units over
+    // the viewport's height, the w component of (x, y, width, height).
+    const int viewport_height = viewport::current_viewport().w;
+    d_frame_data->pixels_per_unit = 0.5f * proj[1][1] * (float)viewport_height;
+    d_particle_instances.next_frame();
 }
 
 void pbr_renderer::end_frame()
 {
     assert(d_frame_data);
-    for_each_shader([&](spkt::shader& shader) {
-        shader.bind();
-        shader.load("u_light_pos", d_frame_data->light_positions);
-        shader.load("u_light_colour",  d_frame_data->light_colours);
-        shader.load("u_light_brightness",  d_frame_data->light_brightnesses);
-    });
-
-    d_staticShader.bind();
-    for (const auto& [key, data] : d_frame_data->static_mesh_draw_commands) {
-        const auto& mesh = d_assetManager->get<static_mesh>(key.first);
+    spkt::gpu_scope scope("pbr");
+
+    // Animated meshes are drawn immediately, which may have prepared some variants
+    // before all of the lights were added. Lights are complete now, so start afresh.
+    d_frame_data->prepared_shaders.clear();
+
+    // Group the draws by pipeline so that each shader variant is bound once, then by
+    // material so that textures are only rebound when they change. Sorting the full key
+    // also makes the submission order deterministic regardless of how the instances
+    // were bucketed.
+    struct pipeline_draw
+    {
+        std::uint32_t features;
+        const std::string* material;
+        const std::string* mesh;
+        const std::vector<model_instance>* instances;
+
+        auto key() const { return std::tie(features, *material, *mesh); }
+    };
+
+    // Instances of packed materials are instead merged by texture array and mesh, with
+    // each instance carrying the index of its material.
+    std::map<std::pair<std::size_t, std::string_view>, std::vector<packed_model_instance>> packed_draws;
+
+    std::vector<pipeline_draw> draws;
+    draws.reserve(d_frame_data->static_meshes.commands.size());
+    for (const auto& [key, instances] : d_frame_data->static_meshes.commands) {
         const auto& mat = d_assetManager->get<material>(key.second);
+        if (d_pack_materials) {
+            if (const auto packed = d_material_packer.pack(mat)) {
+                auto& target = packed_draws[{packed->array, key.first}];
+                target.reserve(target.size() + instances.size());
+                for (const auto& instance : instances) {
+                    target.push_back({instance.position, instance.orientation, instance.scale, packed->index});
+                }
+                continue;
+            }
+        }
+        draws.push_back({mat.features(), &key.second, &key.first, &instances});
+    }
+    std::ranges::sort(draws, {}, [](const pipeline_draw& draw) { return draw.key(); });
+
+    spkt::shader* shader = nullptr;
+    const std::string* current_material = nullptr;
+    for (std::size_t i = 0; i != draws.size(); ++i) {
+        const auto& draw = draws[i];
+        if (i == 0 || draw.features != draws[i - 1].features) {
+            shader = &bind_variant(d_static_shaders, draw.features);
+            current_material = nullptr;
+        }
+
+        const auto& mat = d_assetManager->get<material>(*draw.material);
+        if (!current_material || *current_material != *draw.material) {
+            upload_material(*shader, mat, d_assetManager);
+            current_material = draw.material;
+        }
 
-        upload_material(d_staticShader, mat, d_assetManager);
-        d_instanceBuffer.set_data(data);
+        const auto& mesh = d_assetManager->get<static_mesh>(*draw.mesh);
+        request_textures(mat, uv_screen_size(
+            mesh, *draw.instances, d_frame_data->camera_position, d_frame_data->pixels_per_unit
+        ));
+
+        d_instanceBuffer.set_data(*draw.instances);
         spkt::draw(mesh, &d_instanceBuffer);
     }
-    d_staticShader.unbind();
+
+    if (!packed_draws.empty()) {
+        bind_variant(d_static_shaders, PACKED_MATERIAL_VARIANT);
+        d_material_packer.bind_table();
+        std::size_t bound_array = material_packer::NO_ARRAY;
+        for (const auto& [key, instances] : packed_draws) {
+            const auto [array, mesh] = key;
+            if (array != material_packer::NO_ARRAY && array != bound_array) {
+                d_material_packer.array(array).bind(MATERIAL_LAYERS_SLOT);
+                bound_array = array;
+            }
+            d_packed_instance_buffer.set_data(instances);
+            spkt::draw(d_assetManager->get<static_mesh>(mesh), &d_packed_instance_buffer);
+        }
+    }
+    glUseProgram(0);
+
+    d_texture_streamer.update();
 
     d_frame_data = std::nullopt;
 }
 
+void pbr_renderer::request_textures(const spkt::material& material, float screen_size)
+{
+    const std::uint32_t features = material.features();
+    if (features & MATERIAL_ALBEDO_MAP) {
+        d_texture_streamer.request(d_assetManager->get<texture>(material.albedoMap), screen_size);
+    }
+    if (features & MATERIAL_NORMAL_MAP) {
+        d_texture_streamer.request(d_assetManager->get<texture>(material.normalMap), screen_size);
+    }
+    if (features & MATERIAL_METALLIC_MAP) {
+        d_texture_streamer.request(d_assetManager->get<texture>(material.metallicMap), screen_size);
+    }
+    if (features & MATERIAL_ROUGHNESS_MAP) {
+        d_texture_streamer.request(d_assetManager->get<texture>(material.roughnessMap), screen_size);
+    }
+}
+
 void pbr_renderer::set_ambience(const glm::vec3& colour, const float brightness)
 {
-    for_each_shader([&](spkt::shader& shader) {
-        shader.bind();
-        shader.load("u_ambience_colour", colour);
-        shader.load("u_ambience_brightness", brightness);
-    });
+    d_ambience_colour = colour;
+    d_ambience_brightness = brightness;
 }
 
 void pbr_renderer::set_sunlight(
     const glm::vec3& colour, const glm::vec3& direction, const float brightness)
 {
-    for_each_shader([&](spkt::shader& shader) {
-        shader.bind();
-        shader.load("u_sun_colour", colour);
-        shader.load("u_sun_direction", direction);
-        shader.load("u_sun_brightness", brightness);
-    });
+    d_sun_colour = colour;
+    d_sun_direction = direction;
+    d_sun_brightness = brightness;
 }
 
 void pbr_renderer::add_light(
@@ -154,7 +443,13 @@ void pbr_renderer::draw_static_mesh(
     const std::string& mesh, const std::string& material)
 {
     assert(d_frame_data);
-    d_frame_data->static_mesh_draw_commands[{mesh, material}].push_back({position, orientation, scale});
+    d_frame_data->static_meshes.add(position, orientation, scale, mesh, material);
+}
+
+void pbr_renderer::submit(static_mesh_bucket&& bucket)
+{
+    assert(d_frame_data);
+    d_frame_data->static_meshes.merge(std::move(bucket));
 }
 
 void pbr_renderer::draw_animated_mesh(
@@ -163,29 +458,63 @@ void pbr_renderer::draw_animated_mesh(
     const std::string& animation_name, float animation_time)
 {
     assert(d_frame_data);
-    d_animatedShader.bind();
     const auto& mesh_obj = d_assetManager->get<animated_mesh>(mesh);
     const auto& mat = d_assetManager->get<spkt::material>(material);
-    upload_material(d_animatedShader, mat, d_assetManager);
 
-    d_animatedShader.load("u_model_matrix", make_transform(position, orientation, scale));
+    auto& shader = bind_variant(d_animated_shaders, mat.features());
+    upload_material(shader, mat, d_assetManager);
+
+    // Animated meshes have no bounds to estimate their size on screen from, so their
+    // textures are streamed at full resolution.
+    request_textures(mat, std::numeric_limits<float>::max());
+
+    shader.load("u_model_matrix", make_transform(position, orientation, scale));
     
     auto poses = mesh_obj.get_pose(animation_name, animation_time);
     poses.resize(MAX_BONES, glm::mat4(1.0));
-    d_animatedShader.load("u_bone_transforms", poses);
+    shader.load("u_bone_transforms", poses);
 
     spkt::draw(mesh_obj);
-    d_animatedShader.unbind();
+    shader.unbind();
+}
+
+spkt::streaming_buffer<spkt::model_instance>::allocation pbr_renderer::allocate_particles(std::size_t count)
+{
+    assert(d_frame_data);
+    return d_particle_instances.allocate(count);
 }
 
-void pbr_renderer::draw_particles(std::span<const spkt::model_instance> particles)
+const spkt::static_mesh* pbr_renderer::particle_mesh()
 {
-    d_staticShader.bind();
-    d_instanceBuffer.set_data(particles);
+    if (!d_particle_mesh) {
+        // TODO: Un-hardcode this mesh, do when cleaning up the rendering.
+        const auto& mesh = d_assetManager->get<static_mesh>("resources/Models/Particle.obj");
+        if (mesh.vertex_count() == 0) { return nullptr; } // Still loading
+        d_particle_mesh = &mesh;
+    }
+    return d_particle_mesh;
+}
+
+void pbr_renderer::draw_particles(std::size_t first, std::size_t count)
+{
+    assert(d_frame_data);
+    const auto* mesh = particle_mesh();
+    if (!mesh) { return; }
 
-    // TODO: Un-hardcode this mesh, do when cleaning up the rendering.
-    spkt::draw(d_assetManager->get<static_mesh>("Resources/Models/Particle.obj"), &d_instanceBuffer);
-    d_staticShader.unbind();
+    auto& shader = bind_variant(d_static_shaders, 0);
+    spkt::draw(*mesh, d_particle_instances, first, count);
+    shader.unbind();
 }
 
-}
\ No newline at end of file
+void pbr_renderer::draw_particles(const spkt::gpu_particle_system& particles)
+{
+    assert(d_frame_data);
+    const auto* mesh = particle_mesh();
+    if (!mesh) { return; }
+
+    auto& shader = bind_variant(d_static_shaders, 0);
+    particles.draw(*mesh);
+    shader.unbind();
+}
+
+}
@@ -1,13 +1,19 @@
 #pragma once
 #include <sprocket/graphics/asset_manager.h>
+#include <sprocket/graphics/gpu_particles.h>
+#include <sprocket/graphics/material_packer.h>
 #include <sprocket/graphics/shader.h>
 #include <sprocket/graphics/shadow_map.h>
 #include <sprocket/graphics/buffer.h>
+#include <sprocket/graphics/texture_streamer.h>
 #include <sprocket/utility/hashing.h>
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <functional>
+#include <unordered_set>
 
 namespace spkt {
 
@@ -20,39 +26,104 @@ static constexpr int ROUGHNESS_SLOT = 3;
 // Shadow Map Texture Slot
 static constexpr int SHADOW_MAP_SLOT = 4;
 
+// Texture array slot of packed materials, see material_packer
+static constexpr int MATERIAL_LAYERS_SLOT = 5;
+
 // Animation Data
 static constexpr int MAX_BONES = 50;
 
 // Light Data
 static constexpr int MAX_NUM_LIGHTS = 50;
 
-struct frame_data
+// A collection of static mesh instances grouped by (mesh, material). Buckets can be
+// filled independently on worker threads and then submitted to the renderer, which
+// merges them on the render thread.
+struct static_mesh_bucket
 {
     std::unordered_map<
         std::pair<std::string, std::string>,
         std::vector<spkt::model_instance>,
         spkt::hash_pair
-    > static_mesh_draw_commands;
+    > commands;
+
+    void add(
+        const glm::vec3& position, const glm::quat& orientation, const glm::vec3& scale,
+        const std::string& mesh, const std::string& material
+    );
+
+    void merge(static_mesh_bucket&& other);
+};
+
+struct frame_data
+{
+    static_mesh_bucket static_meshes;
 
     std::array<glm::vec3, spkt::MAX_NUM_LIGHTS> light_positions;
     std::array<glm::vec3, spkt::MAX_NUM_LIGHTS> light_colours;
     std::array<float, spkt::MAX_NUM_LIGHTS>     light_brightnesses;
     std::size_t next_light_index;
+
+    glm::mat4 proj;
+    glm::mat4 view;
+
+    // Used to estimate how large textures appear on screen for streaming.
+    glm::vec3 camera_position;
+    float     pixels_per_unit; // The on-screen size of one unit of length at distance one
+
+    // Variants that have had this frame's camera and lighting uniforms uploaded.
+    std::unordered_set<const spkt::shader*> prepared_shaders;
 };
 
 class pbr_renderer
 {
     spkt::asset_manager* d_assetManager;
 
-    spkt::shader d_staticShader;
-    spkt::shader d_animatedShader;
-
-    void for_each_shader(const std::function<void(spkt::shader& shader)>& callback);
+    spkt::shader_variants d_static_shaders;
+    spkt::shader_variants d_animated_shaders;
     
     spkt::vertex_buffer<spkt::model_instance> d_instanceBuffer;
 
+    // Static meshes whose materials can be packed are drawn with one draw call per mesh
+    // and texture array rather than per mesh and material.
+    spkt::material_packer                            d_material_packer;
+    spkt::vertex_buffer<spkt::packed_model_instance> d_packed_instance_buffer;
+    bool                                             d_pack_materials = true;
+
+    // Particle instances are written straight into this by the caller each frame.
+    spkt::streaming_buffer<spkt::model_instance> d_particle_instances;
+
+    // Resolved once the particle mesh has finished loading.
+    const spkt::static_mesh* d_particle_mesh = nullptr;
+
     std::optional<frame_data> d_frame_data;
 
+    // Textures sampled each frame are requested here, and streamed at the end of the frame.
+    spkt::texture_streamer d_texture_streamer;
+
+    // Lighting state persists between frames and is uploaded to each variant as it is
+    // first used in a frame, so variants compiled part way through still receive it.
+    glm::vec3 d_ambience_colour = {0.0f, 0.0f, 0.0f};
+    float     d_ambience_brightness = 0.0f;
+    glm::vec3 d_sun_colour = {0.0f, 0.0f, 0.0f};
+    glm::vec3 d_sun_direction = {0.0f, -1.0f, 0.0f};
+    float     d_sun_brightness = 0.0f;
+
+    // Shadow cascades, set by enable_shadows. No shadows are applied until then.
+    std::array<glm::mat4, MAX_SHADOW_CASCADES> d_cascade_proj_views = {};
+    std::array<float, MAX_SHADOW_CASCADES>     d_cascade_splits = {};
+    int                                        d_cascade_count = 0;
+
+    // Requests the textures of the material from the streamer, given the largest size on
+    // screen in pixels of one unit of UV space.
+    void request_textures(const spkt::material& material, float screen_size);
+
+    // Binds the given variant, uploading the per-frame uniforms if it has not been used
+    // yet this frame.
+    spkt::shader& bind_variant(spkt::shader_variants& variants, std::uint32_t features);
+
+    // Returns the particle mesh, or nullptr while it is still loading.
+    const spkt::static_mesh* particle_mesh();
+
     pbr_renderer(const pbr_renderer&) = delete;
     pbr_renderer& operator=(const pbr_renderer&) = delete;
 
@@ -71,20 +142,38 @@ public:
         const std::string& mesh, const std::string& material
     );
 
+    // Merges a bucket of static mesh instances into the current frame.
+    void submit(static_mesh_bucket&& bucket);
+
     void draw_animated_mesh(
         const glm::vec3& position, const glm::quat& orientation, const glm::vec3& scale,
         const std::string& mesh, const std::string& material,
         const std::string& animation_name, float animation_time
     );
 
-    void draw_particles(
-        std::span<const spkt::model_instance> particles
-    );
+    // Reserves space for count particle instances this frame, growing the buffer if this
+    // is the first reservation of the frame. The caller writes the instances into the
+    // returned elements and then draws them with draw_particles(first, elements.size()).
+    spkt::streaming_buffer<spkt::model_instance>::allocation allocate_particles(std::size_t count);
+
+    // Draws count particle instances starting at first, as returned by allocate_particles.
+    void draw_particles(std::size_t first, std::size_t count);
+
+    // Draws the live particles of a GPU simulated particle system.
+    void draw_particles(const spkt::gpu_particle_system& particles);
 
     void enable_shadows(const shadow_map& shadowMap);
 
-    spkt::shader& static_shader() { return d_staticShader; }
-    spkt::shader& animated_shader() { return d_animatedShader; }
+    spkt::texture_streamer& texture_streaming() { return d_texture_streamer; }
+
+    void set_material_packing(bool enabled) { d_pack_materials = enabled; }
+    bool material_packing() const { return d_pack_materials; }
+    const spkt::material_packer& packed_materials() const { return d_material_packer; }
+
+    // Returns the shader variant for the given set of material_features, compiling it if needed.
+    spkt::shader& static_shader(std::uint32_t features = 0) { return d_static_shaders.get(features); }
+    spkt::shader& animated_shader(std::uint32_t features = 0) { return d_animated_shaders.get(features); }
+    const spkt::shader_variants& static_shaders() const { return d_static_shaders; }
 };
 
 }
\ No newline at end of file
@@ -68,8 +68,8 @@ void circle_instance::set_buffer_attributes(std::uint32_t vbo)
 shape_renderer::shape_renderer()
     : d_quad_vertices(get_quad_vertices())
     , d_quad_indices(get_quad_indices())
-    , d_line_shader("Resources/Shaders/line.vert", "Resources/Shaders/line.frag")
-    , d_circle_shader("Resources/Shaders/circle.vert", "Resources/Shaders/circle.frag")
+    , d_line_shader("resources/Shaders/line.vert", "resources/Shaders/line.frag")
+    , d_circle_shader("resources/Shaders/circle.vert", "resources/Shaders/circle.frag")
 {
 }
 
@@ -1,6 +1,7 @@
 #include "skybox_renderer.h"
 
 #include <sprocket/graphics/camera.h>
+#include <sprocket/graphics/gpu_profiler.h>
 #include <sprocket/graphics/open_gl.h>
 #include <sprocket/graphics/cube_map.h>
 
@@ -11,14 +12,15 @@
 namespace spkt {
     
 skybox_renderer::skybox_renderer()
-    : d_mesh("Resources/Models/Skybox.obj")
-    , d_shader("Resources/Shaders/Skybox.vert",
-               "Resources/Shaders/Skybox.frag")
+    : d_mesh("resources/Models/Skybox.obj")
+    , d_shader("resources/Shaders/Skybox.vert",
+               "resources/Shaders/Skybox.frag")
 {
 }
 
 void skybox_renderer::draw(const cube_map& skybox, const glm::mat4& proj, const glm::mat4& view)
 {
+    spkt::gpu_scope scope("skybox");
     d_shader.bind();
     d_shader.load("projectionMatrix", proj);
 
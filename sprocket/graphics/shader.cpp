@@ -1,30 +1,104 @@
 #include "shader.h"
 
 #include <sprocket/core/log.h>
+#include <sprocket/graphics/render_stats.h>
+#include <sprocket/graphics/shader_cache.h>
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <filesystem>
 #include <format>
 #include <fstream>
 #include <string>
+#include <unordered_set>
 
 namespace spkt {
 
 namespace {
 
-// Parses a shader source code into a string ready to be compiled.
-std::string parse_shader_source(std::string_view filepath)
+std::string read_file(const std::filesystem::path& filepath)
 {
-	std::ifstream stream(std::string{filepath});
+	std::ifstream stream(filepath);
 	if (!stream) {
-		log::fatal("Shader file '{}' does not exist!", filepath);
+		log::fatal("Shader file '{}' does not exist!", filepath.string());
 	}
 	using iter = std::istreambuf_iterator<char>;
 	return {iter{stream}, iter{}};
 }
 
+// Returns the file named by an #include directive, or an empty view if the line is
+// not an include. Only the quoted form is supported.
+std::string_view include_target(std::string_view line)
+{
+	const auto first = line.find_first_not_of(" \t");
+	if (first == std::string_view::npos || !line.substr(first).starts_with("#include")) {
+		return {};
+	}
+	const auto open = line.find('"', first);
+	const auto close = line.find('"', open + 1);
+	if (open == std::string_view::npos || close == std::string_view::npos) {
+		return {};
+	}
+	return line.substr(open + 1, close - open - 1);
+}
+
+// Appends the given file to the output, recursively expanding #include directives.
+// Includes are resolved relative to the including file and each file is only included
+// once, so shared snippets do not need include guards.
+void expand_includes(
+	const std::filesystem::path& filepath,
+	std::unordered_set<std::string>& included,
+	std::string& output)
+{
+	const std::string source = read_file(filepath);
+	std::string_view remaining = source;
+	while (!remaining.empty()) {
+		const auto end = remaining.find('\n');
+		const auto line = remaining.substr(0, end);
+		remaining.remove_prefix(end == std::string_view::npos ? remaining.size() : end + 1);
+
+		if (auto target = include_target(line); !target.empty()) {
+			const auto include_path = (filepath.parent_path() / target).lexically_normal();
+			if (included.insert(include_path.string()).second) {
+				expand_includes(include_path, included, output);
+			}
+			continue;
+		}
+
+		output.append(line);
+		output.push_back('\n');
+	}
+}
+
+// Parses a shader source code into a string ready to be compiled, expanding includes
+// and injecting the given defines after the #version directive.
+std::string parse_shader_source(std::string_view filepath, const shader_defines& defines)
+{
+	std::unordered_set<std::string> included;
+	std::string source;
+	expand_includes(std::filesystem::path{filepath}, included, source);
+	if (defines.empty()) {
+		return source;
+	}
+
+	std::string define_block;
+	for (const auto& define : defines) {
+		define_block += std::format("#define {}\n", define);
+	}
+
+	// The #version directive must come first, so defines go on the following line.
+	std::size_t insert_pos = 0;
+	if (const auto version = source.find("#version"); version != std::string::npos) {
+		const auto line_end = source.find('\n', version);
+		insert_pos = line_end == std::string::npos ? source.size() : line_end + 1;
+	}
+	source.insert(insert_pos, define_block);
+	return source;
+}
+
 std::uint32_t compile_shader_source(std::uint32_t type, const std::string& source)
 {
 	std::uint32_t id = glCreateShader(type);
@@ -36,7 +110,8 @@ std::uint32_t compile_shader_source(std::uint32_t type, const std::string& sourc
 	glGetShaderiv(id, GL_COMPILE_STATUS, &result);
 
 	if (result == GL_FALSE) {
-        log::error("Could not compile shader {}", (type == GL_VERTEX_SHADER) ? "VERTEX" : "FRAGMENT");
+        const auto stage = type == GL_VERTEX_SHADER ? "VERTEX" : type == GL_FRAGMENT_SHADER ? "FRAGMENT" : "COMPUTE";
+        log::error("Could not compile shader {}", stage);
 		glDeleteShader(id);
 		return 0;
 	}
@@ -48,25 +123,46 @@ std::uint32_t compile_shader_source(std::uint32_t type, const std::string& sourc
 
 shader::shader(
 	std::string_view vert_shader_file,
-	std::string_view frag_shader_file
+	std::string_view frag_shader_file,
+	const shader_defines& defines
 )
-	: d_vert_source(parse_shader_source(vert_shader_file))
-	, d_frag_source(parse_shader_source(frag_shader_file))
+	: d_vert_source(parse_shader_source(vert_shader_file, defines))
+	, d_frag_source(parse_shader_source(frag_shader_file, defines))
 	, d_program_id(glCreateProgram())
-	, d_vert_shader_id(compile_shader_source(GL_VERTEX_SHADER, d_vert_source))
-	, d_frag_shader_id(compile_shader_source(GL_FRAGMENT_SHADER, d_frag_source))
+	, d_vert_shader_id(0)
+	, d_frag_shader_id(0)
 {
+	const std::uint64_t cache_key = shader_cache_key(d_vert_source, d_frag_source);
+	if (load_program_binary(d_program_id, cache_key)) {
+		return;
+	}
+
+	// The cached binary was missing or rejected by the driver, so start again with a
+	// fresh program and compile from source.
+	glDeleteProgram(d_program_id);
+	d_program_id = glCreateProgram();
+	d_vert_shader_id = compile_shader_source(GL_VERTEX_SHADER, d_vert_source);
+	d_frag_shader_id = compile_shader_source(GL_FRAGMENT_SHADER, d_frag_source);
+
+	glProgramParameteri(d_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(d_program_id, d_vert_shader_id);
 	glAttachShader(d_program_id, d_frag_shader_id);
 	glLinkProgram(d_program_id);
 	glValidateProgram(d_program_id);
+
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(d_program_id, GL_LINK_STATUS, &link_status);
+	if (link_status == GL_TRUE) {
+		save_program_binary(d_program_id, cache_key);
+	}
 }
 
 shader::~shader()
 {
     unbind();
-    glDetachShader(d_program_id, d_vert_shader_id);
-    glDetachShader(d_program_id, d_frag_shader_id);
+    // Programs loaded from the binary cache have no shader objects attached.
+    if (d_vert_shader_id) { glDetachShader(d_program_id, d_vert_shader_id); }
+    if (d_frag_shader_id) { glDetachShader(d_program_id, d_frag_shader_id); }
     glDeleteShader(d_vert_shader_id);
     glDeleteShader(d_frag_shader_id);
     glDeleteProgram(d_program_id);
@@ -75,6 +171,7 @@ shader::~shader()
 void shader::bind() const
 {
     glUseProgram(d_program_id);
+    SPKT_RECORD_RENDER_STAT(shader_binds, 1);
 }
 
 void shader::unbind() const
@@ -90,51 +187,61 @@ std::uint32_t shader::uniform_location(const std::string& name) const
 void shader::load(const std::string& name, int value) const
 {
 	glProgramUniform1i(d_program_id, uniform_location(name), value);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, float value) const
 {
 	glProgramUniform1f(d_program_id, uniform_location(name), value);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, const glm::vec2& vector) const
 {
 	glProgramUniform2f(d_program_id, uniform_location(name), vector.x, vector.y);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, const glm::vec3& vector) const
 {
 	glProgramUniform3f(d_program_id, uniform_location(name), vector.x, vector.y, vector.z);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, const glm::vec4& vector) const
 {
 	glProgramUniform4f(d_program_id, uniform_location(name), vector.x, vector.y, vector.z, vector.w);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, const glm::quat& quat) const
 {
 	glProgramUniform4f(d_program_id, uniform_location(name), quat.x, quat.y, quat.z, quat.w);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, const glm::mat4& matrix) const
 {
 	glProgramUniformMatrix4fv(d_program_id, uniform_location(name), 1, GL_FALSE, glm::value_ptr(matrix));
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, std::span<const float> values) const
 {
 	glProgramUniform1fv(d_program_id, uniform_location(name), values.size(), values.data());
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, std::span<const glm::vec3> values) const
 {
 	glProgramUniform3fv(d_program_id, uniform_location(name), values.size(), glm::value_ptr(values[0]));
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 void shader::load(const std::string& name, std::span<const glm::mat4> values) const
 {
 	glProgramUniformMatrix4fv(d_program_id, uniform_location(name), std::ssize(values), GL_FALSE, glm::value_ptr(values[0]));
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
 }
 
 std::string array_name(std::string_view uniformName, std::size_t index)
@@ -183,4 +290,130 @@ bool shader::reload()
 	return true;
 }
 
+compute_shader::compute_shader(std::string_view shader_file, const shader_defines& defines)
+	: d_program_id(glCreateProgram())
+	, d_valid(false)
+{
+	const std::uint32_t shader_id = compile_shader_source(GL_COMPUTE_SHADER, parse_shader_source(shader_file, defines));
+	if (shader_id == 0) {
+		return;
+	}
+
+	glAttachShader(d_program_id, shader_id);
+	glLinkProgram(d_program_id);
+	glDetachShader(d_program_id, shader_id);
+	glDeleteShader(shader_id);
+
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(d_program_id, GL_LINK_STATUS, &link_status);
+	d_valid = link_status == GL_TRUE;
+	if (!d_valid) {
+		log::error("Could not link compute shader {}", shader_file);
+	}
+}
+
+compute_shader::~compute_shader()
+{
+	glDeleteProgram(d_program_id);
+}
+
+void compute_shader::bind() const
+{
+	glUseProgram(d_program_id);
+	SPKT_RECORD_RENDER_STAT(shader_binds, 1);
+}
+
+void compute_shader::unbind() const
+{
+	glUseProgram(0);
+}
+
+void compute_shader::dispatch(std::size_t count, std::size_t group_size) const
+{
+	const auto groups = (GLuint)((count + group_size - 1) / group_size);
+	if (groups > 0) {
+		glDispatchCompute(groups, 1, 1);
+	}
+}
+
+std::uint32_t compute_shader::uniform_location(const std::string& name) const
+{
+	return glGetUniformLocation(d_program_id, name.c_str());
+}
+
+void compute_shader::load(const std::string& name, int value) const
+{
+	glProgramUniform1i(d_program_id, uniform_location(name), value);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
+}
+
+void compute_shader::load(const std::string& name, float value) const
+{
+	glProgramUniform1f(d_program_id, uniform_location(name), value);
+	SPKT_RECORD_RENDER_STAT(uniform_uploads, 1);
+}
+
+shader_variants::shader_variants(
+	std::string_view vert_shader_file,
+	std::string_view frag_shader_file,
+	const std::vector<std::string>& features,
+	const init_callback& init
+)
+	: d_vert_file(vert_shader_file)
+	, d_frag_file(frag_shader_file)
+	, d_features(features)
+	, d_init(init)
+{
+	assert(d_features.size() <= 32);
+}
+
+shader& shader_variants::get(std::uint32_t key)
+{
+	if (auto it = d_variants.find(key); it != d_variants.end()) {
+		return *it->second;
+	}
+
+	shader_defines defines;
+	for (std::size_t bit = 0; bit != d_features.size(); ++bit) {
+		if (key & (1u << bit)) {
+			defines.push_back(d_features[bit]);
+		}
+	}
+
+	auto& variant = d_variants[key];
+	variant = std::make_unique<shader>(d_vert_file, d_frag_file, defines);
+	d_init(*variant);
+	return *variant;
+}
+
+void shader_variants::for_each(const std::function<void(shader&)>& callback)
+{
+	for (auto& [key, variant] : d_variants) {
+		callback(*variant);
+	}
+}
+
+std::vector<std::uint32_t> shader_variants::keys() const
+{
+	std::vector<std::uint32_t> keys;
+	keys.reserve(d_variants.size());
+	for (const auto& [key, variant] : d_variants) {
+		keys.push_back(key);
+	}
+	std::ranges::sort(keys);
+	return keys;
+}
+
+std::string shader_variants::describe(std::uint32_t key) const
+{
+	std::string description;
+	for (std::size_t bit = 0; bit != d_features.size(); ++bit) {
+		if (key & (1u << bit)) {
+			if (!description.empty()) { description += ' '; }
+			description += d_features[bit];
+		}
+	}
+	return description.empty() ? "(none)" : description;
+}
+
 }
\ No newline at end of file
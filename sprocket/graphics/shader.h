@@ -1,14 +1,23 @@
 #pragma once
 #include <glm/glm.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string_view>
 #include <string>
 #include <span>
+#include <unordered_map>
 #include <vector>
 
 namespace spkt {
 
+// Preprocessor definitions injected into both stages of a shader directly after the
+// #version directive. Each entry is emitted as "#define <entry>", so values can be given
+// as "NAME VALUE".
+using shader_defines = std::vector<std::string>;
+
 class shader
 {
     std::string d_vert_source;
@@ -24,7 +33,11 @@ class shader
     shader& operator=(const shader&) = delete;
 
 public:
-    shader(std::string_view vert_shader_file, std::string_view frag_shader_file);
+    shader(
+        std::string_view vert_shader_file,
+        std::string_view frag_shader_file,
+        const shader_defines& defines = {}
+    );
     ~shader();
 
     bool reload();
@@ -51,6 +64,77 @@ public:
 
 using shader_ptr = std::unique_ptr<spkt::shader>;
 
+// A single stage compute program. Unlike shader, it is not cached as a program binary;
+// compute programs are small and only used by optional GPU paths, which check is_valid
+// and fall back to the CPU if compilation failed.
+class compute_shader
+{
+    std::uint32_t d_program_id;
+    bool          d_valid;
+
+    std::uint32_t uniform_location(const std::string& name) const;
+
+    compute_shader(const compute_shader&) = delete;
+    compute_shader& operator=(const compute_shader&) = delete;
+
+public:
+    explicit compute_shader(std::string_view shader_file, const shader_defines& defines = {});
+    ~compute_shader();
+
+    bool is_valid() const { return d_valid; }
+
+    void bind() const;
+    void unbind() const;
+
+    // Dispatches enough work groups of the given size to cover count invocations.
+    void dispatch(std::size_t count, std::size_t group_size) const;
+
+    void load(const std::string& name, int value) const;
+    void load(const std::string& name, float value) const;
+};
+
+// Lazily compiles and caches permutations of a single shader. Each bit of a permutation
+// key enables the define at the corresponding index of the feature list, so variants
+// only pay for the features they use and dead branches are compiled out.
+class shader_variants
+{
+public:
+    using init_callback = std::function<void(spkt::shader&)>;
+
+private:
+    std::string d_vert_file;
+    std::string d_frag_file;
+    std::vector<std::string> d_features;
+
+    // Called once for each newly compiled variant, for setting uniforms such as sampler
+    // slots that never change.
+    init_callback d_init;
+
+    std::unordered_map<std::uint32_t, spkt::shader_ptr> d_variants;
+
+    shader_variants(const shader_variants&) = delete;
+    shader_variants& operator=(const shader_variants&) = delete;
+
+public:
+    shader_variants(
+        std::string_view vert_shader_file,
+        std::string_view frag_shader_file,
+        const std::vector<std::string>& features,
+        const init_callback& init = [](spkt::shader&) {}
+    );
+
+    spkt::shader& get(std::uint32_t key);
+
+    // Iterates over all variants that have been compiled so far.
+    void for_each(const std::function<void(spkt::shader&)>& callback);
+
+    // The keys of the variants compiled so far, in ascending order.
+    std::vector<std::uint32_t> keys() const;
+
+    // The defines enabled by a key separated by spaces, or "(none)", for display.
+    std::string describe(std::uint32_t key) const;
+};
+
 // Formats an OpenGL array indexed name 
 std::string array_name(std::string_view uniform_name, std::size_t index);
 
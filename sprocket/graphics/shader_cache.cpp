@@ -0,0 +1,122 @@
+#include "shader_cache.h"
+
+#include <sprocket/core/log.h>
+#include <sprocket/utility/hashing.h>
+
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace spkt {
+namespace {
+
+constexpr std::uint32_t CACHE_MAGIC = 0x53504b54; // "SPKT"
+constexpr std::string_view CACHE_DIRECTORY = ".cache/shaders";
+
+std::string cache_file(std::uint64_t key)
+{
+    return std::format("{}/{:016x}.bin", CACHE_DIRECTORY, key);
+}
+
+std::string_view gl_string(GLenum name)
+{
+    const auto* str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? std::string_view{str} : std::string_view{};
+}
+
+bool binary_formats_supported()
+{
+    static const bool supported = [] {
+        GLint num_formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+        return num_formats > 0;
+    }();
+    return supported;
+}
+
+}
+
+std::uint64_t shader_cache_key(std::string_view vert_source, std::string_view frag_source)
+{
+    static const std::uint64_t driver_hash = [] {
+        std::uint64_t hash = fnv1a(gl_string(GL_VENDOR));
+        hash = fnv1a(gl_string(GL_RENDERER), hash);
+        return fnv1a(gl_string(GL_VERSION), hash);
+    }();
+
+    // Include the lengths so that moving text between the stages changes the key.
+    std::uint64_t hash = fnv1a(vert_source, driver_hash);
+    hash = fnv1a(std::to_string(vert_source.size()), hash);
+    return fnv1a(frag_source, hash);
+}
+
+bool load_program_binary(std::uint32_t program_id, std::uint64_t key)
+{
+    if (!binary_formats_supported()) {
+        return false;
+    }
+
+    std::ifstream stream(cache_file(key), std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+
+    std::uint32_t magic = 0;
+    GLenum format = 0;
+    std::uint64_t size = 0;
+    stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    stream.read(reinterpret_cast<char*>(&format), sizeof(format));
+    stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!stream || magic != CACHE_MAGIC) {
+        return false;
+    }
+
+    std::vector<char> binary(size);
+    stream.read(binary.data(), size);
+    if (!stream) {
+        return false;
+    }
+
+    glProgramBinary(program_id, format, binary.data(), (GLsizei)binary.size());
+
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &link_status);
+    return link_status == GL_TRUE;
+}
+
+void save_program_binary(std::uint32_t program_id, std::uint64_t key)
+{
+    if (!binary_formats_supported()) {
+        return;
+    }
+
+    GLint size = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(size);
+    GLenum format = 0;
+    glGetProgramBinary(program_id, size, nullptr, &format, binary.data());
+
+    std::error_code ec;
+    std::filesystem::create_directories(CACHE_DIRECTORY, ec);
+    if (ec) {
+        log::warn("Could not create shader cache directory: {}", ec.message());
+        return;
+    }
+
+    std::ofstream stream(cache_file(key), std::ios::binary);
+    const std::uint64_t length = binary.size();
+    stream.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+    stream.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    stream.write(binary.data(), binary.size());
+}
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace spkt {
+
+// Linked shader programs are cached on disk via glGetProgramBinary so that subsequent
+// runs can skip compiling and linking GLSL. Entries are keyed by a hash of the shader
+// sources and the driver vendor/renderer/version strings, so editing a shader or
+// updating the driver naturally invalidates the entry.
+std::uint64_t shader_cache_key(std::string_view vert_source, std::string_view frag_source);
+
+// Attempts to load the cached binary for the given key into the program. Returns true
+// if the program is now successfully linked, and false if there was no entry or the
+// driver rejected it, in which case the caller should fall back to compiling.
+bool load_program_binary(std::uint32_t program_id, std::uint64_t key);
+
+// Writes the binary of a linked program to the cache. The program should have been
+// linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+void save_program_binary(std::uint32_t program_id, std::uint64_t key);
+
+}
@@ -1,45 +1,262 @@
 #include "shadow_map.h"
 
+#include <sprocket/graphics/gpu_profiler.h>
+#include <sprocket/graphics/mesh.h>
 #include <sprocket/graphics/render_context.h>
+#include <sprocket/graphics/viewport.h>
 
 #include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
 
 namespace spkt {
+namespace {
+
+// Recovers the near and far planes from a perspective projection matrix.
+std::pair<float, float> near_far_planes(const glm::mat4& proj)
+{
+    const float near_plane = proj[3][2] / (proj[2][2] - 1.0f);
+    const float far_plane = proj[3][2] / (proj[2][2] + 1.0f);
+    return {near_plane, far_plane};
+}
+
+bool sphere_in_bounds(
+    const glm::vec3& centre, float radius, const glm::vec3& min, const glm::vec3& max)
+{
+    return centre.x + radius >= min.x && centre.x - radius <= max.x
+        && centre.y + radius >= min.y && centre.y - radius <= max.y
+        && centre.z + radius >= min.z && centre.z - radius <= max.z;
+}
+
+bool same_placement(const shadow_cascade& a, const shadow_cascade& b)
+{
+    return a.min_bounds == b.min_bounds && a.max_bounds == b.max_bounds;
+}
+
+bool same_instance(const model_instance& a, const model_instance& b)
+{
+    return a.position == b.position && a.orientation == b.orientation && a.scale == b.scale;
+}
+
+float max_scale(const model_instance& instance)
+{
+    return std::max({instance.scale.x, instance.scale.y, instance.scale.z});
+}
+
+std::uint32_t make_depth_array(const shadow_map_settings& settings)
+{
+    std::uint32_t id = 0;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id);
+    glTextureStorage3D(
+        id, 1, GL_DEPTH_COMPONENT32F,
+        settings.resolution, settings.resolution, (GLsizei)settings.cascade_count
+    );
+    glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Anything sampled outside of a cascade is treated as unshadowed.
+    const float border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTextureParameterfv(id, GL_TEXTURE_BORDER_COLOR, border);
+    return id;
+}
 
-shadow_map::shadow_map(asset_manager* assetManager)
+}
+
+shadow_map::shadow_map(asset_manager* assetManager, const shadow_map_settings& settings)
     : d_asset_manager(assetManager)
-    , d_shader("Resources/Shaders/ShadowMap.vert", "Resources/Shaders/ShadowMap.frag")
-    , d_light_view() // Will be populated after starting a scene.
-    , d_light_proj(glm::ortho(-25.0f, 25.0f, -25.0f, 25.0f, -50.0f, 50.0f))
-    , d_shadow_map(8192, 8192)
+    , d_shader("resources/Shaders/ShadowMap.vert", "resources/Shaders/ShadowMap.frag")
+    , d_settings(settings)
+    , d_depth_texture(0)
+    , d_static_depth_texture(0)
+    , d_fbo(0)
+    , d_sun_direction(0.0f)
+    , d_light_view(1.0f) // Will be populated after starting a scene.
+    , d_cascades()
+    , d_cached_cascades()
+    , d_cache_valid()
+    , d_draw_count(0)
 {
-    d_shader.bind();
-    d_shader.load("u_proj_matrix", d_light_proj);
+    d_settings.cascade_count = std::clamp<std::size_t>(d_settings.cascade_count, 1, MAX_SHADOW_CASCADES);
+
+    d_depth_texture = make_depth_array(d_settings);
+    if (d_settings.cache_static_casters) {
+        d_static_depth_texture = make_depth_array(d_settings);
+    }
+
+    glCreateFramebuffers(1, &d_fbo);
+    glNamedFramebufferDrawBuffer(d_fbo, GL_NONE);
+    glNamedFramebufferReadBuffer(d_fbo, GL_NONE);
 }
 
-glm::mat4 shadow_map::get_light_proj_view() const
+shadow_map::~shadow_map()
 {
-    return d_light_proj * d_light_view;
+    glDeleteFramebuffers(1, &d_fbo);
+    glDeleteTextures(1, &d_depth_texture);
+    if (d_static_depth_texture) { glDeleteTextures(1, &d_static_depth_texture); }
 }
 
-const texture& shadow_map::get_texture() const
+void shadow_map::bind_texture(int slot) const
 {
-    return d_shadow_map.depth_texture();
+    glBindTextureUnit(slot, d_depth_texture);
 }
 
-void shadow_map::begin_frame(const glm::vec3& position, const glm::vec3& sun_dir)
+void shadow_map::begin_frame(const glm::mat4& proj, const glm::mat4& view, const glm::vec3& sun_dir)
 {
     assert(!d_frame_data);
     d_frame_data = shadow_map_frame{};
-    d_light_view = glm::lookAt(position - sun_dir, position, {0.0, 1.0, 0.0});
-    d_shader.bind();
-    d_shader.load("u_view_matrix", d_light_view);
-    d_shader.unbind();
+
+    // Small sun movements are ignored when caching so that the cached layers remain
+    // valid; the shadows catch up once the sun has turned past the threshold.
+    const glm::vec3 new_dir = glm::normalize(sun_dir);
+    if (!d_settings.cache_static_casters
+        || glm::dot(new_dir, d_sun_direction) < std::cos(d_settings.sun_angle_threshold))
+    {
+        d_sun_direction = new_dir;
+        d_cache_valid.fill(false);
+    }
+
+    // The light view only depends on the sun direction, so that snapping the cascade
+    // centres to texels in light space is stable as the camera moves.
+    const glm::vec3 dir = d_sun_direction;
+    const glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3{0.0f, 0.0f, 1.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+    d_light_view = glm::lookAt(glm::vec3{0.0f}, dir, up);
+
+    // Corners of the camera frustum in world space, near plane first.
+    const glm::mat4 inv_proj_view = glm::inverse(proj * view);
+    std::array<glm::vec3, 8> corners;
+    for (int i = 0; i != 8; ++i) {
+        const glm::vec4 ndc{(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f};
+        const glm::vec4 world = inv_proj_view * ndc;
+        corners[i] = glm::vec3(world) / world.w;
+    }
+
+    const auto [near_plane, far_plane] = near_far_planes(proj);
+    const float shadow_far = std::min(far_plane, d_settings.max_distance);
+    const float count = (float)d_settings.cascade_count;
+
+    // The cascades move in steps of this many texels, and are widened to match.
+    const float resolution = (float)d_settings.resolution;
+    const float step_texels = d_settings.cache_static_casters
+        ? std::clamp(std::round(resolution * d_settings.cached_cascade_step), 1.0f, resolution / 2.0f)
+        : 1.0f;
+
+    float split_begin = near_plane;
+    for (std::size_t i = 0; i != d_settings.cascade_count; ++i) {
+        const float p = (float)(i + 1) / count;
+        const float log_split = near_plane * std::pow(shadow_far / near_plane, p);
+        const float uniform_split = near_plane + (shadow_far - near_plane) * p;
+        const float split_end = glm::mix(uniform_split, log_split, d_settings.split_lambda);
+
+        // Points along a view ray are linear in view depth, so the corners of the slice
+        // are found by interpolating the near and far corners of the whole frustum.
+        const float t0 = (split_begin - near_plane) / (far_plane - near_plane);
+        const float t1 = (split_end - near_plane) / (far_plane - near_plane);
+        std::array<glm::vec3, 8> slice;
+        glm::vec3 centre{0.0f};
+        for (int c = 0; c != 4; ++c) {
+            slice[c] = glm::mix(corners[c], corners[c + 4], t0);
+            slice[c + 4] = glm::mix(corners[c], corners[c + 4], t1);
+            centre += slice[c] + slice[c + 4];
+        }
+        centre /= 8.0f;
+
+        // A bounding sphere keeps the cascade size constant under camera rotation.
+        float radius = 0.0f;
+        for (const auto& corner : slice) {
+            radius = std::max(radius, glm::length(corner - centre));
+        }
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // The cascade is wide enough to hold the sphere wherever it sits within a step,
+        // so its lower bounds can be snapped down to a whole step. A step is a whole
+        // number of texels, which keeps the rasterised shadow from shimmering, and the
+        // bounds only change when the camera crosses into the next step. Depth is snapped
+        // in the same way so that it does not change the bounds either.
+        const float texel = 2.0f * radius / (resolution - step_texels);
+        const float step = texel * step_texels;
+        const float width = texel * resolution;
+        const glm::vec3 light_centre = glm::vec3(d_light_view * glm::vec4(centre, 1.0f));
+
+        auto& cascade = d_cascades[i];
+        cascade.split_depth = split_end;
+        cascade.min_bounds = glm::floor((light_centre - glm::vec3{radius}) / step) * step;
+        cascade.max_bounds = cascade.min_bounds + glm::vec3{width, width, width + d_settings.caster_distance};
+
+        // The light looks down -z, so the near and far planes are the negated z bounds.
+        const glm::mat4 light_proj = glm::ortho(
+            cascade.min_bounds.x, cascade.max_bounds.x,
+            cascade.min_bounds.y, cascade.max_bounds.y,
+            -cascade.max_bounds.z, -cascade.min_bounds.z
+        );
+        cascade.proj_view = light_proj * d_light_view;
+
+        split_begin = split_end;
+    }
+}
+
+void shadow_map::attach_layer(std::uint32_t texture, std::size_t layer)
+{
+    glNamedFramebufferTextureLayer(d_fbo, GL_DEPTH_ATTACHMENT, texture, 0, (GLint)layer);
+}
+
+void shadow_map::draw_casters(const shadow_cascade& cascade, const shadow_caster_commands& commands)
+{
+    for (const auto& [key, data] : commands) {
+        const auto& mesh = d_asset_manager->get<static_mesh>(key);
+
+        d_visible.clear();
+        for (const auto& instance : data) {
+            const glm::vec3 centre = glm::vec3(d_light_view * glm::vec4(instance.position, 1.0f));
+            const float radius = mesh.bounding_radius() * max_scale(instance);
+            if (sphere_in_bounds(centre, radius, cascade.min_bounds, cascade.max_bounds)) {
+                d_visible.push_back(instance);
+            }
+        }
+
+        if (!d_visible.empty()) {
+            d_instance_buffer.set_data(d_visible);
+            spkt::draw(mesh, &d_instance_buffer);
+            ++d_draw_count;
+        }
+    }
+}
+
+void shadow_map::update_static_casters()
+{
+    for (auto it = d_static_casters.begin(); it != d_static_casters.end();) {
+        if (!it->second.submitted) {
+            d_dirty_casters.emplace_back(it->second.mesh, it->second.instance);
+            it = d_static_casters.erase(it);
+        } else {
+            it->second.submitted = false;
+            ++it;
+        }
+    }
+
+    for (const auto& [mesh_name, instance] : d_dirty_casters) {
+        const auto& mesh = d_asset_manager->get<static_mesh>(mesh_name);
+        const glm::vec3 centre = glm::vec3(d_light_view * glm::vec4(instance.position, 1.0f));
+        const float radius = mesh.bounding_radius() * max_scale(instance);
+        for (std::size_t i = 0; i != d_settings.cascade_count; ++i) {
+            const auto& cascade = d_cascades[i];
+            if (sphere_in_bounds(centre, radius, cascade.min_bounds, cascade.max_bounds)) {
+                d_cache_valid[i] = false;
+            }
+        }
+    }
+    d_dirty_casters.clear();
 }
 
 void shadow_map::end_frame()
 {
     assert(d_frame_data);
+    spkt::gpu_scope scope("shadows");
     spkt::render_context rc;
     rc.depth_testing(true);
 
@@ -47,16 +264,63 @@ void shadow_map::end_frame()
     // casting shadows.
     rc.set_face_cull(GL_FRONT);
 
+    // Casters closer to the sun than a cascade's near plane are flattened onto it
+    // rather than clipped.
+    glEnable(GL_DEPTH_CLAMP);
+
     d_shader.bind();
-    d_shadow_map.bind();
-    glClear(GL_DEPTH_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, d_fbo);
+    spkt::viewport viewport(0, 0, d_settings.resolution, d_settings.resolution);
+
+    d_draw_count = 0;
+    const bool caching = d_settings.cache_static_casters;
+    shadow_caster_commands static_commands;
+    if (caching) {
+        update_static_casters();
 
-    for (const auto& [key, data] : d_frame_data->commands) {
-        d_instance_buffer.set_data(data);
-        spkt::draw(d_asset_manager->get<static_mesh>(key), &d_instance_buffer);
+        // Only gather the static casters if some cascade needs redrawing.
+        const auto count = d_settings.cascade_count;
+        for (std::size_t i = 0; i != count; ++i) {
+            if (!d_cache_valid[i] || !same_placement(d_cached_cascades[i], d_cascades[i])) {
+                for (const auto& [id, caster] : d_static_casters) {
+                    static_commands[caster.mesh].push_back(caster.instance);
+                }
+                break;
+            }
+        }
     }
 
-    d_shadow_map.unbind();
+    for (std::size_t i = 0; i != d_settings.cascade_count; ++i) {
+        const auto& cascade = d_cascades[i];
+        d_shader.load("u_light_proj_view", cascade.proj_view);
+
+        if (caching) {
+            if (!d_cache_valid[i] || !same_placement(d_cached_cascades[i], cascade)) {
+                attach_layer(d_static_depth_texture, i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                draw_casters(cascade, static_commands);
+
+                // Meshes still loading are drawn as empty, so redraw until they arrive.
+                d_cache_valid[i] = !d_asset_manager->is_loading<static_mesh>();
+                d_cached_cascades[i] = cascade;
+            }
+
+            glCopyImageSubData(
+                d_static_depth_texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)i,
+                d_depth_texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)i,
+                d_settings.resolution, d_settings.resolution, 1
+            );
+            attach_layer(d_depth_texture, i);
+        } else {
+            attach_layer(d_depth_texture, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+
+        draw_casters(cascade, d_frame_data->commands);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDisable(GL_DEPTH_CLAMP);
     d_shader.unbind();
 
     d_frame_data = std::nullopt;
@@ -72,4 +336,32 @@ void shadow_map::add_mesh(
     d_frame_data->commands[mesh].push_back({position, orientation, scale});
 }
 
-}
\ No newline at end of file
+void shadow_map::add_static_mesh(
+    std::uint64_t id,
+    const std::string& mesh,
+    const glm::vec3& position,
+    const glm::quat& orientation,
+    const glm::vec3& scale)
+{
+    assert(d_frame_data);
+    if (!d_settings.cache_static_casters) {
+        add_mesh(mesh, position, orientation, scale);
+        return;
+    }
+
+    const model_instance instance{position, orientation, scale};
+    auto [it, inserted] = d_static_casters.try_emplace(id, static_shadow_caster{mesh, instance, true});
+    auto& caster = it->second;
+    caster.submitted = true;
+    if (inserted) {
+        d_dirty_casters.emplace_back(mesh, instance);
+    }
+    else if (caster.mesh != mesh || !same_instance(caster.instance, instance)) {
+        d_dirty_casters.emplace_back(caster.mesh, caster.instance);
+        d_dirty_casters.emplace_back(mesh, instance);
+        caster.mesh = mesh;
+        caster.instance = instance;
+    }
+}
+
+}
@@ -1,42 +1,145 @@
 #pragma once
 #include <sprocket/graphics/asset_manager.h>
 #include <sprocket/graphics/buffer.h>
-#include <sprocket/graphics/frame_buffer.h>
 #include <sprocket/graphics/open_gl.h>
 #include <sprocket/graphics/shader.h>
-#include <sprocket/graphics/texture.h>
 
 #include <glm/glm.hpp>
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
-#include <optional>
 
 namespace spkt {
 
+// Must match MAX_CASCADES in Entity_PBR.frag
+static constexpr std::size_t MAX_SHADOW_CASCADES = 4;
+
+struct shadow_map_settings
+{
+    // Number of cascades, between 1 and MAX_SHADOW_CASCADES.
+    std::size_t cascade_count = 4;
+
+    // Width and height of the depth texture of each cascade.
+    int resolution = 2048;
+
+    // Distance from the camera beyond which nothing receives shadows.
+    float max_distance = 100.0f;
+
+    // Blends between uniform (0) and logarithmic (1) cascade splits. Logarithmic splits
+    // give more resolution close to the camera.
+    float split_lambda = 0.75f;
+
+    // How far towards the sun beyond a cascade that casters are still rendered, so that
+    // tall objects outside of the view still cast shadows into it.
+    float caster_distance = 50.0f;
+
+    // When enabled, static casters are rendered into their own cached depth layers which
+    // are only redrawn when the cascade moves, the static casters within it change, or
+    // the sun turns by more than sun_angle_threshold radians. Dynamic casters are drawn
+    // on top of a copy of the cache each frame. This doubles the depth memory.
+    bool  cache_static_casters = true;
+    float sun_angle_threshold = 0.01f;
+
+    // While caching, cascades follow the camera in steps of this fraction of their width
+    // rather than a texel at a time, so that the cached layers survive camera movement.
+    // Each cascade is widened by one step to keep its slice of the view covered, which
+    // costs that fraction of its resolution.
+    float cached_cascade_step = 0.125f;
+};
+
+struct shadow_cascade
+{
+    glm::mat4 proj_view;
+
+    // The view-space depth at which this cascade ends.
+    float split_depth;
+
+    // Light space bounds used for culling casters.
+    glm::vec3 min_bounds;
+    glm::vec3 max_bounds;
+};
+
+using shadow_caster_commands = std::unordered_map<std::string, std::vector<model_instance>>;
+
 struct shadow_map_frame
 {
-    std::unordered_map<std::string, std::vector<model_instance>> commands;
+    shadow_caster_commands commands;
+};
+
+struct static_shadow_caster
+{
+    std::string    mesh;
+    model_instance instance;
+    bool           submitted; // Whether this caster was submitted in the current frame
 };
 
+// Cascaded shadow maps for a directional light. Each frame, the camera frustum (clipped
+// to max_distance) is split into cascades which are each fitted with a bounding sphere
+// so their size does not change as the camera rotates, and then snapped to a grid of
+// whole texels so that shadows do not shimmer as the camera moves. The cascades are stored as
+// layers of a single depth texture array.
+//
+// Static casters are retained between frames: they must be submitted every frame with
+// add_static_mesh, and any that are added, moved or not submitted mark their region of
+// the cached layers as dirty.
 class shadow_map
 {
     spkt::asset_manager*                      d_asset_manager;
     spkt::shader                              d_shader;
-    spkt::frame_buffer                        d_shadow_map;
     spkt::vertex_buffer<spkt::model_instance> d_instance_buffer;
+    shadow_map_settings                       d_settings;
+
+    std::uint32_t d_depth_texture;
+    std::uint32_t d_static_depth_texture;
+    std::uint32_t d_fbo;
 
     std::optional<shadow_map_frame> d_frame_data;
 
+    // The sun direction the light view was built from. It is only updated when the sun
+    // moves beyond the threshold, so the cached layers stay aligned in between.
+    glm::vec3 d_sun_direction;
     glm::mat4 d_light_view;
-    glm::mat4 d_light_proj;
+    std::array<shadow_cascade, MAX_SHADOW_CASCADES> d_cascades;
+
+    std::unordered_map<std::uint64_t, static_shadow_caster> d_static_casters;
+
+    // Casters whose previous or new bounds need redrawing in the cached layers.
+    std::vector<std::pair<std::string, model_instance>> d_dirty_casters;
+
+    // The placement of each cascade when its cached layer was drawn.
+    std::array<shadow_cascade, MAX_SHADOW_CASCADES> d_cached_cascades;
+    std::array<bool, MAX_SHADOW_CASCADES>           d_cache_valid;
+
+    std::size_t d_draw_count;
+    std::vector<model_instance> d_visible;
+
+    void attach_layer(std::uint32_t texture, std::size_t layer);
+
+    // Draws the given casters that intersect the cascade into the attached layer.
+    void draw_casters(const shadow_cascade& cascade, const shadow_caster_commands& commands);
+
+    // Invalidates the cached layers overlapping the dirty casters and drops any static
+    // casters that were not submitted this frame.
+    void update_static_casters();
+
+    shadow_map(const shadow_map&) = delete;
+    shadow_map& operator=(const shadow_map&) = delete;
 
 public:
-    shadow_map(spkt::asset_manager* assetManager);
+    shadow_map(spkt::asset_manager* assetManager, const shadow_map_settings& settings = {});
+    ~shadow_map();
 
-    void begin_frame(const glm::vec3& position, const glm::vec3& sun_dir);
+    // Takes the projection and view matrices of the camera that will view the scene.
+    void begin_frame(const glm::mat4& proj, const glm::mat4& view, const glm::vec3& sun_dir);
     void end_frame();
 
+    // Adds a caster that is drawn this frame only.
     void add_mesh(
         const std::string& mesh,
         const glm::vec3& position,
@@ -44,8 +147,25 @@ public:
         const glm::vec3& scale
     );
 
-    glm::mat4 get_light_proj_view() const;
-    const texture& get_texture() const;
+    // Adds or updates a static caster, identified by id, which is cached between frames.
+    // If static caching is disabled, this is equivalent to add_mesh.
+    void add_static_mesh(
+        std::uint64_t id,
+        const std::string& mesh,
+        const glm::vec3& position,
+        const glm::quat& orientation,
+        const glm::vec3& scale
+    );
+
+    std::size_t cascade_count() const { return d_settings.cascade_count; }
+    const shadow_cascade& cascade(std::size_t index) const { return d_cascades[index]; }
+    const shadow_map_settings& settings() const { return d_settings; }
+
+    // The number of draw calls issued by the last call to end_frame.
+    std::size_t draw_count() const { return d_draw_count; }
+
+    // Binds the depth texture array to the given slot.
+    void bind_texture(int slot) const;
 };
 
-}
\ No newline at end of file
+}
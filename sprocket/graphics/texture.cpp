@@ -1,15 +1,45 @@
 #include "texture.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <sprocket/core/log.h>
+#include <sprocket/graphics/render_stats.h>
+
 #include <glad/glad.h>
+#include <jpeglib.h>
+#include <png.h>
 
+#include <algorithm>
+#include <cassert>
+#include <csetjmp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <span>
+#include <utility>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// S3TC is an extension and anisotropic filtering is only core from 4.6, so the loader
+// may not define them.
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
 
 namespace spkt {
 namespace {
 
+// Anisotropic filtering beyond this gives little visible benefit for the cost.
+constexpr float MAX_ANISOTROPY = 8.0f;
+
+std::size_t s_total_bytes = 0;
+
 void SetTextureParameters(std::uint32_t id)
 {
     glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -18,6 +48,178 @@ void SetTextureParameters(std::uint32_t id)
     glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 }
 
+// Trilinear filtering, plus anisotropic filtering where it is supported.
+void SetMipmapParameters(std::uint32_t id)
+{
+    static const float anisotropy = [] {
+        float max_anisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+        return std::min(max_anisotropy, MAX_ANISOTROPY);
+    }();
+
+    glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    if (anisotropy > 1.0f) {
+        glTextureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+    }
+}
+
+// PNG and JPEG images are decoded straight into a pixel_buffer, which is in the unpack
+// pool if there is room, so the pixels are never copied on the way to the GPU. Files are
+// told apart by their contents as some of the assets have the wrong extension.
+enum class image_kind
+{
+    PNG,
+    JPEG,
+    OTHER
+};
+
+image_kind image_kind_of(const std::string& file)
+{
+    unsigned char header[8] = {};
+    std::ifstream stream(file, std::ios::binary);
+    stream.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (stream.gcount() == sizeof(header) && png_sig_cmp(header, 0, sizeof(header)) == 0) {
+        return image_kind::PNG;
+    }
+    if (stream.gcount() >= 3 && header[0] == 0xFF && header[1] == 0xD8 && header[2] == 0xFF) {
+        return image_kind::JPEG;
+    }
+    return image_kind::OTHER;
+}
+
+texture_data load_png(const std::string& file)
+{
+    png_image image = {};
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, file.c_str())) {
+        log::error("Could not load texture '{}': {}", file, image.message);
+        return {};
+    }
+    image.format = PNG_FORMAT_RGBA;
+
+    texture_data td;
+    td.width = (int)image.width;
+    td.height = (int)image.height;
+    td.bytes = pixel_buffer::allocate(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, nullptr, td.bytes.data(), 0, nullptr)) {
+        log::error("Could not load texture '{}': {}", file, image.message);
+        png_image_free(&image);
+        return {};
+    }
+    td.generate_mips = true;
+    return td;
+}
+
+// libjpeg reports errors through a callback that must not return, so it jumps back to
+// the loader, which then cleans up.
+struct jpeg_error
+{
+    jpeg_error_mgr manager;
+    std::jmp_buf   jump;
+};
+
+void on_jpeg_error(j_common_ptr info)
+{
+    std::longjmp(reinterpret_cast<jpeg_error*>(info->err)->jump, 1);
+}
+
+texture_data load_jpeg(const std::string& file)
+{
+    std::FILE* stream = std::fopen(file.c_str(), "rb");
+    if (!stream) {
+        log::error("Could not open texture '{}'", file);
+        return {};
+    }
+
+    jpeg_decompress_struct info;
+    jpeg_error error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = on_jpeg_error;
+
+    // Declared before the jump target so that a failed decode still releases the pixels.
+    texture_data td;
+    if (setjmp(error.jump)) {
+        char message[JMSG_LENGTH_MAX];
+        error.manager.format_message(reinterpret_cast<j_common_ptr>(&info), message);
+        log::error("Could not load texture '{}': {}", file, message);
+        jpeg_destroy_decompress(&info);
+        std::fclose(stream);
+        return {};
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_stdio_src(&info, stream);
+    jpeg_read_header(&info, TRUE);
+    info.out_color_space = JCS_EXT_RGBA;
+    jpeg_start_decompress(&info);
+
+    td.width = (int)info.output_width;
+    td.height = (int)info.output_height;
+    td.bytes = pixel_buffer::allocate((std::size_t)td.width * td.height * 4);
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = td.bytes.data() + (std::size_t)info.output_scanline * td.width * 4;
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    std::fclose(stream);
+    td.generate_mips = true;
+    return td;
+}
+
+texture_data load_dds(const std::string& file)
+{
+    std::ifstream stream(file, std::ios::binary);
+    const auto info = dds::read_header(stream);
+    if (!info || info->cube_map) {
+        log::error("'{}' is not a DDS texture in a supported format", file);
+        return {};
+    }
+
+    texture_data td;
+    td.width = info->width;
+    td.height = info->height;
+    td.format = info->format;
+    td.mip_levels = info->mip_levels;
+    td.file = file;
+    td.file_offset = (std::size_t)stream.tellg();
+
+    // Only the tail of the mip chain is read now, the rest is streamed in when needed.
+    // Textures without a mip chain are read in full as they cannot be streamed.
+    const auto level_size = [&](int level) {
+        return mip_size(td.format, std::max(td.width >> level, 1), std::max(td.height >> level, 1));
+    };
+    while (td.base_level + 1 < td.mip_levels
+        && std::max(td.width >> td.base_level, td.height >> td.base_level) > STREAMING_TAIL_SIZE) {
+        stream.seekg(level_size(td.base_level), std::ios::cur);
+        ++td.base_level;
+    }
+
+    std::size_t size = 0;
+    for (int level = td.base_level; level != td.mip_levels; ++level) {
+        size += level_size(level);
+    }
+    td.bytes = pixel_buffer::allocate(size);
+    stream.read(reinterpret_cast<char*>(td.bytes.data()), size);
+    if (!stream) {
+        log::error("'{}' is truncated", file);
+        return {};
+    }
+    return td;
+}
+
+}
+
+std::uint32_t gl_internal_format(texture_format format)
+{
+    switch (format) {
+        case texture_format::RGBA8: return GL_RGBA8;
+        case texture_format::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case texture_format::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case texture_format::BC5: return GL_COMPRESSED_RG_RGTC2;
+    }
+    return GL_RGBA8;
 }
 
 texture::texture(const texture_data& data)
@@ -25,15 +227,36 @@ texture::texture(const texture_data& data)
     , d_width(data.width)
     , d_height(data.height)
     , d_channels(spkt::texture_channels::RGBA)
+    , d_format(data.format)
 {
-    glCreateTextures(GL_TEXTURE_2D, 1, &d_id);
-    SetTextureParameters(d_id);
-    glTextureStorage2D(d_id, 1, GL_RGBA8, d_width, d_height);
-    glTextureSubImage2D(d_id, 0, 0, 0, d_width, d_height, GL_RGBA, GL_UNSIGNED_BYTE, data.bytes.data());
+    if (d_width <= 0 || d_height <= 0) {
+        return;
+    }
+
+    const bool generate = data.generate_mips && data.mip_levels == 1;
+    d_levels = generate ? full_mip_count(d_width, d_height) : data.mip_levels;
+    d_resident_level = data.base_level;
+    d_tail_level = data.base_level;
+    if (data.base_level > 0) {
+        d_file = data.file;
+        d_file_offset = data.file_offset;
+    }
+
+    d_id = create_storage(d_resident_level);
+    if (generate) {
+        upload_levels(d_id, 0, 0, 1, data.bytes);
+        glGenerateTextureMipmap(d_id);
+    } else {
+        upload_levels(d_id, d_resident_level, d_resident_level, d_levels, data.bytes);
+    }
+
+    d_bytes = mip_bytes(d_resident_level, d_levels);
+    s_total_bytes += d_bytes;
 }
 
 texture::texture(int width, int height, texture_channels channels)
-    : d_width(width)
+    : d_id(0)
+    , d_width(width)
     , d_height(height)
     , d_channels(channels)
 {
@@ -49,19 +272,146 @@ texture::texture()
 
 texture::~texture()
 {
+    if (d_array) { d_array->remove(d_layer); }
     if (d_id > 0) { glDeleteTextures(1, &d_id); }
+    s_total_bytes -= d_bytes;
 }
 
 texture_data texture::load(const std::string& file)
 {
+    if (std::filesystem::path(file).extension() == ".dds") {
+        return load_dds(file);
+    }
+
+    switch (image_kind_of(file)) {
+        case image_kind::PNG: return load_png(file);
+        case image_kind::JPEG: return load_jpeg(file);
+        case image_kind::OTHER: break;
+    }
+
+    // stb_image decodes other formats into memory of its own, so they are copied.
+    int width = 0;
+    int height = 0;
+    unsigned char* d = stbi_load(file.c_str(), &width, &height, nullptr, 4);
+    if (!d) {
+        log::error("Could not load texture '{}': {}", file, stbi_failure_reason());
+        return {};
+    }
+
     texture_data td;
-    unsigned char* d = stbi_load(file.c_str(), &td.width, &td.height, nullptr, 4);
-    std::span<unsigned char> span_data{d, (std::size_t)(td.width * td.height * 4)};
-    td.bytes = {span_data.begin(), span_data.end()};
+    td.width = width;
+    td.height = height;
+    td.bytes = pixel_buffer::copy_of({d, (std::size_t)width * height * 4});
     stbi_image_free(d);
+    td.generate_mips = true;
     return td;
 }
 
+std::uint32_t texture::create_storage(int base_level) const
+{
+    std::uint32_t id = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &id);
+    SetTextureParameters(id);
+    glTextureStorage2D(
+        id, d_levels - base_level, gl_internal_format(d_format),
+        std::max(d_width >> base_level, 1), std::max(d_height >> base_level, 1)
+    );
+    if (d_levels - base_level > 1) {
+        SetMipmapParameters(id);
+    }
+    return id;
+}
+
+void texture::upload_levels(
+    std::uint32_t id, int base_level, int first, int last, const pixel_buffer& bytes) const
+{
+    // Pixels in the unpack pool are copied by the GPU, asynchronously to this thread.
+    const GLenum format = gl_internal_format(d_format);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bytes.unpack_buffer());
+    std::size_t offset = 0;
+    for (int level = first; level != last; ++level) {
+        const int width = std::max(d_width >> level, 1);
+        const int height = std::max(d_height >> level, 1);
+        const std::size_t size = mip_size(d_format, width, height);
+        assert(offset + size <= bytes.size());
+        const unsigned char* data = bytes.source() + offset;
+        if (is_compressed(d_format)) {
+            glCompressedTextureSubImage2D(id, level - base_level, 0, 0, width, height, format, (GLsizei)size, data);
+        } else {
+            glTextureSubImage2D(id, level - base_level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+        offset += size;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+std::size_t texture::mip_bytes(int first, int last) const
+{
+    std::size_t size = 0;
+    for (int level = first; level < last; ++level) {
+        size += mip_size(d_format, std::max(d_width >> level, 1), std::max(d_height >> level, 1));
+    }
+    return size;
+}
+
+void texture::set_resident_level(int level, const pixel_buffer& bytes)
+{
+    level = std::clamp(level, 0, d_levels - 1);
+    if (!d_id || level == d_resident_level) {
+        return;
+    }
+
+    // Texture storage is immutable, so build a new texture with the new set of levels,
+    // copying across the levels that both have on the GPU.
+    const std::uint32_t id = create_storage(level);
+    for (int l = std::max(level, d_resident_level); l != d_levels; ++l) {
+        glCopyImageSubData(
+            d_id, GL_TEXTURE_2D, l - d_resident_level, 0, 0, 0,
+            id, GL_TEXTURE_2D, l - level, 0, 0, 0,
+            std::max(d_width >> l, 1), std::max(d_height >> l, 1), 1
+        );
+    }
+    if (level < d_resident_level) {
+        upload_levels(id, level, level, d_resident_level, bytes);
+    }
+
+    glDeleteTextures(1, &d_id);
+    d_id = id;
+    d_resident_level = level;
+
+    s_total_bytes -= d_bytes;
+    d_bytes = mip_bytes(d_resident_level, d_levels);
+    s_total_bytes += d_bytes;
+}
+
+void texture::view_layer(texture_array& array, int layer)
+{
+    assert(d_resident_level == 0);
+    assert(!d_array || (d_array == &array && d_layer == layer));
+
+    // A view must be made from a name that has no texture object yet.
+    std::uint32_t id = 0;
+    glGenTextures(1, &id);
+    glTextureView(id, GL_TEXTURE_2D, array.id(), gl_internal_format(d_format), 0, d_levels, layer, 1);
+    SetTextureParameters(id);
+    if (d_levels > 1) {
+        SetMipmapParameters(id);
+    }
+
+    if (d_id > 0) { glDeleteTextures(1, &d_id); }
+    d_id = id;
+    d_array = &array;
+    d_layer = layer;
+
+    s_total_bytes -= d_bytes;
+    d_bytes = 0; // Counted by the array
+}
+
+std::size_t texture::total_memory()
+{
+    return s_total_bytes;
+}
+
 void texture::resize(int width, int height)
 {
     if (d_id) {
@@ -93,11 +443,16 @@ void texture::resize(int width, int height)
 
     d_width = width;
     d_height = height;
+
+    s_total_bytes -= d_bytes;
+    d_bytes = (std::size_t)width * height * (d_channels == texture_channels::RED ? 1 : 4);
+    s_total_bytes += d_bytes;
 }
 
 void texture::bind(int slot) const
 {
     glBindTextureUnit(slot, d_id);
+    SPKT_RECORD_RENDER_STAT(texture_binds, 1);
 }
 
 std::uint32_t texture::id() const
@@ -129,4 +484,98 @@ void texture::set_subtexture(
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // Reset back to initial value
 }
 
-}
\ No newline at end of file
+texture_array::texture_array(int width, int height, texture_format format, int levels)
+    : d_width(width)
+    , d_height(height)
+    , d_format(format)
+    , d_levels(levels)
+{
+}
+
+texture_array::~texture_array()
+{
+    for (auto* tex : d_textures) {
+        if (tex) { tex->leave_array(); }
+    }
+    if (d_id > 0) { glDeleteTextures(1, &d_id); }
+    s_total_bytes -= d_bytes;
+}
+
+bool texture_array::accepts(const texture& tex) const
+{
+    return tex.width() == d_width && tex.height() == d_height
+        && tex.format() == d_format && tex.mip_levels() == d_levels
+        && tex.resident_level() == 0;
+}
+
+int texture_array::add(texture& tex)
+{
+    assert(accepts(tex));
+
+    // Array storage is immutable too, so grow by doubling and copy the existing layers.
+    if (d_free_layers.empty() && d_layers == d_capacity) {
+        const int capacity = std::max(2 * d_capacity, 4);
+        std::uint32_t id = 0;
+        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id);
+        SetTextureParameters(id);
+        glTextureStorage3D(id, d_levels, gl_internal_format(d_format), d_width, d_height, capacity);
+        if (d_levels > 1) {
+            SetMipmapParameters(id);
+        }
+
+        for (int level = 0; level != d_levels && d_layers > 0; ++level) {
+            glCopyImageSubData(
+                d_id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                std::max(d_width >> level, 1), std::max(d_height >> level, 1), d_layers
+            );
+        }
+        // The old storage is only freed once no texture views it.
+        const std::uint32_t old_id = std::exchange(d_id, id);
+        for (int layer = 0; layer != d_layers; ++layer) {
+            if (d_textures[layer]) { d_textures[layer]->view_layer(*this, layer); }
+        }
+        if (old_id > 0) { glDeleteTextures(1, &old_id); }
+        d_capacity = capacity;
+
+        s_total_bytes -= d_bytes;
+        d_bytes = (std::size_t)capacity * tex.mip_bytes(0, d_levels);
+        s_total_bytes += d_bytes;
+    }
+
+    int layer = d_layers;
+    if (!d_free_layers.empty()) {
+        layer = d_free_layers.back();
+        d_free_layers.pop_back();
+    } else {
+        d_textures.push_back(nullptr);
+        ++d_layers;
+    }
+
+    for (int level = 0; level != d_levels; ++level) {
+        glCopyImageSubData(
+            tex.id(), GL_TEXTURE_2D, level, 0, 0, 0,
+            d_id, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+            std::max(d_width >> level, 1), std::max(d_height >> level, 1), 1
+        );
+    }
+    tex.view_layer(*this, layer);
+    d_textures[layer] = &tex;
+    return layer;
+}
+
+void texture_array::remove(int layer)
+{
+    assert(d_textures[layer]);
+    d_textures[layer] = nullptr;
+    d_free_layers.push_back(layer);
+    ++d_generation;
+}
+
+void texture_array::bind(int slot) const
+{
+    glBindTextureUnit(slot, d_id);
+    SPKT_RECORD_RENDER_STAT(texture_binds, 1);
+}
+
+}
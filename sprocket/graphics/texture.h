@@ -1,21 +1,46 @@
 #pragma once
+#include <sprocket/graphics/dds.h>
+#include <sprocket/graphics/pixel_buffer.h>
+
 #include <glm/glm.hpp>
 
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <vector>
 #include <string>
 
 namespace spkt {
 
+// Cooked textures only load the levels of their mip chain up to this size to begin with,
+// the more detailed levels are streamed in when needed, see texture_streamer.
+constexpr int STREAMING_TAIL_SIZE = 64;
+
+// The OpenGL internal format that textures of the given format are stored in.
+std::uint32_t gl_internal_format(texture_format format);
+
 struct texture_data
 {
-    int width;
+    int width;  // Of level 0, even if it is not stored
     int height;
-    std::vector<unsigned char> bytes;
+    pixel_buffer bytes; // Each stored mip level in turn, largest first
+
+    texture_format format = texture_format::RGBA8;
+    int mip_levels = 1; // In the full mip chain
+    int base_level = 0; // The most detailed level stored in bytes
+
+    // If only the top level is stored, generate the rest of the mip chain on upload.
+    bool generate_mips = false;
+
+    // Where the levels above base_level can be read from later.
+    std::string file;
+    std::size_t file_offset = 0; // Of level 0
 
     static texture_data load(const std::string& file);
 };
 
+class texture_array;
+
 enum class texture_channels
 {
     RGBA,
@@ -31,6 +56,28 @@ class texture
     int d_height;
 
     texture_channels d_channels;
+    texture_format   d_format = texture_format::RGBA8;
+
+    int d_levels = 1;         // In the full mip chain
+    int d_resident_level = 0; // The most detailed level on the GPU
+    int d_tail_level = 0;     // The most detailed level that is never evicted
+
+    // Where streamed levels are read from, empty if the texture is not streamed.
+    std::string d_file;
+    std::size_t d_file_offset = 0;
+
+    std::size_t d_bytes = 0; // Estimated GPU memory, see memory()
+
+    // The array and layer this texture is a view of, see view_layer().
+    texture_array* d_array = nullptr;
+    int            d_layer = -1;
+
+    // Creates a texture object holding the levels from base_level down.
+    std::uint32_t create_storage(int base_level) const;
+
+    // Uploads levels [first, last) from bytes into a texture made by create_storage.
+    void upload_levels(std::uint32_t id, int base_level, int first, int last,
+                       const pixel_buffer& bytes) const;
 
     texture(const texture&) = delete;
     texture& operator=(const texture&) = delete;
@@ -42,6 +89,9 @@ public:
     texture();
     ~texture();
 
+    // Loads a cooked .dds file (see texture_cooker) with its mip chain as stored, or a PNG,
+    // JPEG or other image format supported by stb_image, which is given a generated mip
+    // chain. PNGs and JPEGs are decoded straight into the unpack pool.
     static texture_data load(const std::string& file);
 
     void bind(int slot) const;
@@ -51,13 +101,101 @@ public:
     int width() const { return d_width; }
     int height() const { return d_height; }
     float aspect_ratio() const { return (float)d_width / (float)d_height; }
+    texture_channels channels() const { return d_channels; }
 
     bool operator==(const texture& other) const;
 
+    // The estimated GPU memory used by this texture, and by all live textures. A texture
+    // that views a layer of a texture_array owns no memory of its own.
+    std::size_t memory() const { return d_bytes; }
+    static std::size_t total_memory();
+
+    // Mip streaming, see texture_streamer. Levels above the resident level are not on the
+    // GPU, and sampling is clamped to the resident level.
+    bool is_streamed() const { return !d_file.empty(); }
+    int mip_levels() const { return d_levels; }
+    int resident_level() const { return d_resident_level; }
+    int tail_level() const { return d_tail_level; }
+    texture_format format() const { return d_format; }
+    const std::string& file() const { return d_file; }
+    std::size_t file_offset() const { return d_file_offset; }
+
+    // The number of bytes in levels [first, last).
+    std::size_t mip_bytes(int first, int last) const;
+
+    // Makes level the most detailed resident level. When adding levels, bytes holds the levels
+    // from level up to the current resident level, and is ignored when dropping levels.
+    void set_resident_level(int level, const pixel_buffer& bytes = {});
+
+    // Replaces the storage of this texture with a view of a layer of the array, which holds
+    // the same levels and format, releasing the original storage. Used by texture_array so
+    // that packed textures are not held on the GPU twice. The layer is freed again when
+    // this texture is destroyed.
+    void view_layer(texture_array& array, int layer);
+
+    // Called by an array that is destroyed first. The view keeps the layer's pixels alive.
+    void leave_array() { d_array = nullptr; d_layer = -1; }
+
     // Mutable Texture Functions
     void set_subtexture(const glm::ivec4& region, const unsigned char* data);
     void resize(int width, int height);
 
 };
 
-}
\ No newline at end of file
+// A GL_TEXTURE_2D_ARRAY of textures that share a size, format and number of mip levels.
+// Layers are filled by copying existing textures on the GPU, after which each texture
+// becomes a view of its layer, so the pixels are only stored once and the texture can
+// still be bound on its own. Materials whose textures are all in the same array can be
+// drawn together, see material_packer.
+class texture_array
+{
+    std::uint32_t d_id = 0;
+
+    int            d_width;
+    int            d_height;
+    texture_format d_format;
+    int            d_levels;
+
+    int d_layers = 0; // Including free layers
+    int d_capacity = 0;
+
+    // The texture viewing each layer, or null if the layer is free. They are given views of
+    // the new storage whenever the array grows.
+    std::vector<spkt::texture*> d_textures;
+    std::vector<int>            d_free_layers;
+    std::uint32_t               d_generation = 0;
+
+    std::size_t d_bytes = 0; // Estimated GPU memory, counted in texture::total_memory()
+
+    texture_array(const texture_array&) = delete;
+    texture_array& operator=(const texture_array&) = delete;
+
+public:
+    texture_array(int width, int height, texture_format format, int levels);
+    ~texture_array();
+
+    // Whether the texture has the size, format and mip levels of this array.
+    bool accepts(const texture& tex) const;
+
+    // Copies every mip level of the texture into a free layer, makes the texture a view of
+    // that layer and returns its index. The texture must be accepted by this array.
+    int add(texture& tex);
+
+    // Frees the layer of a texture that is being destroyed, for reuse by later textures.
+    void remove(int layer);
+
+    void bind(int slot) const;
+
+    std::uint32_t id() const { return d_id; }
+    int layers() const { return d_layers; }
+
+    // The texture in the given layer, or null if it is free.
+    const spkt::texture* texture_at(int layer) const { return d_textures[layer]; }
+
+    // Incremented whenever a layer is freed, so that anything holding layer indices knows
+    // they may now hold another texture.
+    std::uint32_t generation() const { return d_generation; }
+    std::size_t memory() const { return d_bytes; }
+};
+
+}
@@ -0,0 +1,175 @@
+#include "texture_streamer.h"
+
+#include <sprocket/core/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace spkt {
+namespace {
+
+pixel_buffer read_levels(const std::string& file, std::size_t offset, std::size_t size)
+{
+    auto bytes = pixel_buffer::allocate(size);
+    std::ifstream stream(file, std::ios::binary);
+    stream.seekg(offset);
+    stream.read(reinterpret_cast<char*>(bytes.data()), size);
+    if (!stream) {
+        log::error("Failed to stream mip levels from '{}'", file);
+        return {};
+    }
+    return bytes;
+}
+
+}
+
+texture_streamer::texture_streamer(std::size_t memory_budget, std::size_t bytes_per_frame)
+    : d_memory_budget(memory_budget)
+    , d_bytes_per_frame(bytes_per_frame)
+{
+}
+
+int texture_streamer::wanted_level(const texture& tex, const streamed_texture& state) const
+{
+    return state.last_used == d_frame ? state.wanted_level : tex.tail_level();
+}
+
+void texture_streamer::request(texture& tex, float screen_size)
+{
+    if (!tex.is_streamed()) {
+        return;
+    }
+
+    // Each level halves the resolution, so pick the least detailed level that still has at least
+    // one texel per pixel.
+    const float texels = (float)std::max(tex.width(), tex.height());
+    const float ratio = texels / std::max(screen_size, 1.0f);
+    const int level = std::clamp((int)std::floor(std::log2(std::max(ratio, 1.0f))), 0, tex.tail_level());
+
+    auto& state = d_textures[&tex];
+    if (state.last_used != d_frame) {
+        state.wanted_level = level;
+        state.last_used = d_frame;
+    } else {
+        state.wanted_level = std::min(state.wanted_level, level);
+    }
+}
+
+void texture_streamer::update()
+{
+    // Reads that finish beyond the per-frame limit are uploaded next frame instead.
+    std::size_t uploaded = 0;
+    for (auto& [tex, state] : d_textures) {
+        if (uploaded >= d_bytes_per_frame) {
+            break;
+        }
+        if (!state.load.valid() || state.load.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            continue;
+        }
+        const auto bytes = state.load.get();
+        if (bytes.empty()) {
+            state.failed = true;
+            continue;
+        }
+        tex->set_resident_level(state.load_level, bytes);
+        uploaded += bytes.size();
+    }
+
+    evict();
+    start_loads();
+    ++d_frame;
+}
+
+void texture_streamer::evict()
+{
+    // Room is made for the levels that are wanted as well as to get back within budget.
+    // Textures with reads in flight are left alone, as the read is for the levels above
+    // their current resident level.
+    std::size_t wanted = 0;
+    std::vector<std::pair<texture*, const streamed_texture*>> candidates;
+    for (const auto& [tex, state] : d_textures) {
+        if (state.load.valid()) {
+            wanted += tex->mip_bytes(state.load_level, tex->resident_level());
+            continue;
+        }
+        const int level = wanted_level(*tex, state);
+        if (level > tex->resident_level()) {
+            candidates.emplace_back(tex, &state);
+        } else if (!state.failed) {
+            wanted += tex->mip_bytes(level, tex->resident_level());
+        }
+    }
+    std::ranges::sort(candidates, {}, [](const auto& candidate) { return candidate.second->last_used; });
+
+    for (const auto& [tex, state] : candidates) {
+        if (texture::total_memory() + wanted <= d_memory_budget) {
+            break;
+        }
+        tex->set_resident_level(wanted_level(*tex, *state));
+    }
+}
+
+void texture_streamer::start_loads()
+{
+    struct candidate
+    {
+        texture*          tex;
+        streamed_texture* state;
+        int               missing; // The number of levels wanted but not resident
+    };
+
+    std::vector<candidate> candidates;
+    std::size_t memory = texture::total_memory();
+    for (auto& [tex, state] : d_textures) {
+        if (state.load.valid()) {
+            memory += tex->mip_bytes(state.load_level, tex->resident_level());
+        } else if (!state.failed) {
+            const int missing = tex->resident_level() - wanted_level(*tex, state);
+            if (missing > 0) {
+                candidates.push_back({tex, &state, missing});
+            }
+        }
+    }
+    std::ranges::sort(candidates, std::greater{}, &candidate::missing);
+
+    // Levels are read in from the smallest missing level up, so quality improves a level
+    // at a time and a single large texture cannot starve the others of the limit.
+    std::size_t issued = 0;
+    for (const auto& [tex, state, missing] : candidates) {
+        const int resident = tex->resident_level();
+        int level = resident;
+        while (level > resident - missing) {
+            const std::size_t size = tex->mip_bytes(level - 1, resident);
+            const bool first_read = issued == 0 && level == resident;
+            if (memory + size > d_memory_budget || (!first_read && issued + size > d_bytes_per_frame)) {
+                break;
+            }
+            --level;
+        }
+        if (level == resident) {
+            continue;
+        }
+
+        const std::size_t size = tex->mip_bytes(level, resident);
+        const std::size_t offset = tex->file_offset() + tex->mip_bytes(0, level);
+        state->load_level = level;
+        state->load = std::async(std::launch::async, read_levels, tex->file(), offset, size);
+        issued += size;
+        memory += size;
+        if (issued >= d_bytes_per_frame) {
+            break;
+        }
+    }
+}
+
+std::size_t texture_streamer::pending_count() const
+{
+    return std::ranges::count_if(d_textures, [](const auto& entry) { return entry.second.load.valid(); });
+}
+
+}
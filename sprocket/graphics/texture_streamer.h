@@ -0,0 +1,83 @@
+#pragma once
+#include <sprocket/graphics/pixel_buffer.h>
+#include <sprocket/graphics/texture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+namespace spkt {
+
+// Streams the mip levels of cooked textures in and out of GPU memory. Streamed textures
+// start with only the tail of their mip chain resident (see STREAMING_TAIL_SIZE). Each
+// frame the renderer requests the textures it samples along with an estimate of how
+// large they appear on screen, and once per frame update() reads in the levels that are
+// missing and drops the levels that are no longer needed to stay within the budget.
+class texture_streamer
+{
+public:
+    static constexpr std::size_t DEFAULT_MEMORY_BUDGET = 512 * 1024 * 1024;
+    static constexpr std::size_t DEFAULT_BYTES_PER_FRAME = 8 * 1024 * 1024;
+
+private:
+    struct streamed_texture
+    {
+        int           wanted_level = 0; // The most detailed level requested in the last frame it was used
+        std::uint64_t last_used = 0;    // The frame of the latest request
+
+        // Levels being read from disk, from load_level up to the resident level.
+        std::future<pixel_buffer> load;
+        int                       load_level = 0;
+
+        bool failed = false; // Set if a read fails, the texture is not streamed again
+    };
+
+    std::unordered_map<texture*, streamed_texture> d_textures;
+
+    std::size_t   d_memory_budget;
+    std::size_t   d_bytes_per_frame;
+    std::uint64_t d_frame = 1;
+
+    texture_streamer(const texture_streamer&) = delete;
+    texture_streamer& operator=(const texture_streamer&) = delete;
+
+    // The most detailed level the texture needs, falling back to its tail if it was not
+    // requested this frame.
+    int wanted_level(const texture& tex, const streamed_texture& state) const;
+
+    // Drops levels from textures that have more resident than they need until the wanted
+    // levels of all textures fit within the budget, least recently used first.
+    void evict();
+
+    // Starts reading in the levels that textures are missing, most needed first.
+    void start_loads();
+
+public:
+    texture_streamer(std::size_t memory_budget = DEFAULT_MEMORY_BUDGET,
+                     std::size_t bytes_per_frame = DEFAULT_BYTES_PER_FRAME);
+
+    // Notes that the texture is sampled this frame across screen_size pixels per unit of
+    // UV space. Textures that are not streamed are ignored.
+    void request(texture& tex, float screen_size);
+
+    // Uploads finished reads, evicts and starts new reads. Call once per frame, after
+    // the frame's requests have been made.
+    void update();
+
+    // The budget applies to all texture memory, see texture::total_memory, though only
+    // streamed textures are evicted to meet it. The per-frame limit caps both the bytes
+    // read from disk and the bytes uploaded each frame.
+    void set_memory_budget(std::size_t bytes) { d_memory_budget = bytes; }
+    void set_bytes_per_frame(std::size_t bytes) { d_bytes_per_frame = bytes; }
+    std::size_t memory_budget() const { return d_memory_budget; }
+    std::size_t bytes_per_frame() const { return d_bytes_per_frame; }
+
+    // The number of streamed textures that have been requested and the number that are
+    // waiting on reads.
+    std::size_t streamed_count() const { return d_textures.size(); }
+    std::size_t pending_count() const;
+};
+
+}
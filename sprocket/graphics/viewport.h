@@ -25,7 +25,7 @@ public:
     void set(int x, int y, int width, int height);
     void restore();
 
-    // Returns the current dimensions of the viewport
+    // Returns the current dimensions of the viewport as (x, y, width, height)
     static glm::ivec4 current_viewport();
 
     // Returns the current aspect ratio of the viewport
@@ -1,12 +1,22 @@
 #include "font.h"
 
 #include <sprocket/core/log.h>
+#include <sprocket/utility/hashing.h>
+#include <sprocket/utility/utf8.h>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
 
 #include <cassert>
 #include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
 
 namespace spkt {
 
@@ -14,42 +24,70 @@ static constexpr int HRES = 64;
 static constexpr float HRESf = 64.0f;
 static constexpr int DPI = 72;
 
-namespace {
+// Glyphs are rasterised at this size and scaled to the size they are drawn at.
+static constexpr float REFERENCE_SIZE = 32.0f;
 
-uint32_t to_utf32(const char* c)
-{
-    uint32_t result = -1;
+// How far, in pixels at the reference size, the distance field extends beyond each
+// glyph's outline. This bounds how far the edge can be smoothed when scaled up.
+static constexpr int SPREAD = 4;
 
-    if (!c) {
-        return result;
-    }
+static constexpr std::uint32_t CACHE_MAGIC = 0x53504b46; // "SPKF"
+static constexpr std::string_view CACHE_DIRECTORY = ".cache/fonts";
 
-    if ((c[0] & 0x80) == 0x0) {
-        result = c[0];
-    }
+// Laid out strings kept by font::layout before the least recently used are evicted.
+static constexpr std::size_t MAX_CACHED_LAYOUTS = 4096;
 
-    if ((c[0] & 0xC0) == 0xC0) {
-        result = ((c[0] & 0x3F) << 6 ) | (c[1] & 0x3F);
-    }
+// Bump when the cache layout, or how glyphs are rasterised, changes.
+static constexpr std::uint32_t CACHE_VERSION = 1;
 
-    if ((c[0] & 0xE0) == 0xE0) {
-        result = ((c[0] & 0x1F) << (6 + 6)) | ((c[1] & 0x3F) << 6) | (c[2] & 0x3F);
-    }
+namespace {
 
-    if ((c[0] & 0xF0) == 0xF0) {
-        result = ((c[0] & 0x0F) << (6 + 6 + 6)) | ((c[1] & 0x3F) << (6 + 6)) | ((c[2] & 0x3F) << 6) | (c[3] & 0x3F);
-    }
+std::uint64_t kerning_key(codepoint_t left, codepoint_t right)
+{
+    return ((std::uint64_t)left << 32) | right;
+}
 
-    if ((c[0] & 0xF8) == 0xF8) {
-        result = ((c[0] & 0x07) << (6 + 6 + 6 + 6)) | ((c[1] & 0x3F) << (6 + 6 + 6)) | ((c[2] & 0x3F) << (6 + 6)) | ((c[3] & 0x3F) << 6) | (c[4] & 0x3F);
-    }
+struct kerning_entry
+{
+    codepoint_t left;
+    codepoint_t right;
+    float       kerning;
+};
+
+std::string cache_file(std::uint64_t key)
+{
+    return std::format("{}/{:016x}.bin", CACHE_DIRECTORY, key);
+}
+
+// Cache files are only read back by the build that wrote them, so values are stored as
+// their in-memory representation.
+template <typename Range>
+void write_range(std::ostream& stream, const Range& values)
+{
+    using T = std::ranges::range_value_t<Range>;
+    static_assert(std::is_trivially_copyable_v<T>);
+    const std::uint64_t size = std::ranges::size(values);
+    stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    stream.write(reinterpret_cast<const char*>(std::ranges::data(values)), size * sizeof(T));
+}
 
-    return result;
+template <typename T>
+bool read_vector(std::istream& stream, std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::uint64_t size = 0;
+    stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!stream || size > (1u << 24)) {
+        return false;
+    }
+    values.resize(size);
+    stream.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+    return (bool)stream;
 }
 
-bool load_face(const std::string& filename, float size, FT_Library *library, FT_Face *face)
+// Creates a face from the font file data, set to the given size.
+FT_Face create_face(FT_Library library, const std::vector<unsigned char>& data, float size)
 {
-    FT_Error error;
     FT_Matrix matrix = {
         (int)((1.0/HRES) * 0x10000L),
         (int)((0.0)      * 0x10000L),
@@ -59,177 +97,355 @@ bool load_face(const std::string& filename, float size, FT_Library *library, FT_
     assert(library);
     assert(size);
 
-    error = FT_Init_FreeType(library);
-    if (error) {
-        return false;
-    }
-
-    error = FT_New_Face(*library, filename.c_str(), 0, face);
-    if (error) {
-        FT_Done_FreeType(*library);
-        return false;
+    FT_Face face = nullptr;
+    if (FT_New_Memory_Face(library, data.data(), (FT_Long)data.size(), 0, &face)) {
+        return nullptr;
     }
 
-    error = FT_Select_Charmap(*face, FT_ENCODING_UNICODE);
-    if (error) {
-        FT_Done_Face(*face);
-        FT_Done_FreeType(*library);
-        return false;
+    if (FT_Select_Charmap(face, FT_ENCODING_UNICODE)
+        || FT_Set_Char_Size(face, (int)(size * HRES), 0, DPI * HRES, DPI)) {
+        FT_Done_Face(face);
+        return nullptr;
     }
 
-    error = FT_Set_Char_Size(*face, (int)(size * HRES), 0, DPI * HRES, DPI);
-    if (error) {
-        FT_Done_Face(*face);
-        FT_Done_FreeType(*library);
-        return false;
-    }
+    FT_Set_Transform(face, &matrix, NULL);
+    return face;
+}
 
-    FT_Set_Transform(*face, &matrix, NULL);
-    return true;
 }
 
-void generate_kerning(
-    const glyph_map& glyphs,
-    kerning_map& kernings,
-    FT_Library* library,
-    FT_Face* face)
+font::font(const std::string& filename)
+    : d_atlas(1024, 1024)
+    , d_filename(filename)
 {
-    if (!FT_HAS_KERNING(*face)) {
+    std::ifstream file(filename, std::ios::binary);
+    d_file_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (d_file_data.empty()) {
+        log::error("Could not read font '{}'", filename);
+        return;
+    }
+    if (FT_Init_FreeType(&d_library)) {
+        log::error("Could not initialise FreeType for font '{}'", filename);
+        d_library = nullptr;
         return;
     }
 
-    kernings.clear();
-    for (const auto [lcp, leftGlyph] : glyphs) {
-        FT_UInt leftIndex = FT_Get_Char_Index(*face, (FT_ULong)lcp);
+    FT_Int spread = SPREAD;
+    FT_Property_Set(d_library, "bsdf", "spread", &spread);
 
-        for (const auto [rcp, rightGlyph] : glyphs) {
-            FT_UInt rightIndex = FT_Get_Char_Index(*face, (FT_ULong)rcp);
-        
-            FT_Vector kerning;
-            FT_Get_Kerning(*face, leftIndex, rightIndex, FT_KERNING_UNFITTED, &kerning);
-            if (kerning.x) {
-                auto key = std::make_pair(lcp, rcp);
-                kernings.emplace(key, kerning.x / (HRESf * HRESf));
-            }
-        }
+    d_face = create_face(d_library, d_file_data, REFERENCE_SIZE);
+    if (!d_face) {
+        log::error("Could not load font '{}'", filename);
     }
 }
 
+font::~font()
+{
+    if (d_face) { FT_Done_Face(d_face); }
+    if (d_library) { FT_Done_FreeType(d_library); }
 }
 
-font::font(const std::string& filename)
-    : d_atlas(1024, 1024)
-    , d_filename(filename)
+const glyph* font::find_glyph(codepoint_t codepoint)
 {
+    if (codepoint < d_ascii_glyphs.size()) {
+        if (const glyph* glyph = d_ascii_glyphs[codepoint]) {
+            return glyph;
+        }
+    } else if (auto it = d_glyphs.find(codepoint); it != d_glyphs.end()) {
+        return &it->second;
+    }
+
+    // If we could not find it, attempt to load it
+    if (!load_glyph(codepoint)) {
+        return nullptr;
+    }
+    return &d_glyphs.at(codepoint);
 }
 
-glyph font::get_glyph(char c, float size)
+void font::add_glyph(const glyph& glyph)
 {
-    auto& font = d_font_data[size];
-
-    uint32_t ucodepoint = to_utf32(&c);
-    auto it = font.glyphs.find(ucodepoint);
-    if (it != font.glyphs.end()) {
-        return it->second;
+    const auto& added = d_glyphs[glyph.codepoint] = glyph;
+    if (glyph.codepoint < d_ascii_glyphs.size()) {
+        d_ascii_glyphs[glyph.codepoint] = &added;
     }
+}
 
-    // If we could not find it, attempt to load it
-    load_glyph(c, size);
-    it = font.glyphs.find(ucodepoint);
-    if (it != font.glyphs.end()) {
-        return it->second;
+glyph font::get_glyph(codepoint_t codepoint, float size)
+{
+    const glyph* found = find_glyph(codepoint);
+    if (!found) {
+        return glyph(); // Empty glyph
     }
 
-    return glyph(); // Empty glyph
+    const float scale = size / REFERENCE_SIZE;
+    glyph scaled = *found;
+    scaled.width   *= scale;
+    scaled.height  *= scale;
+    scaled.offset  *= scale;
+    scaled.advance *= scale;
+    scaled.padding *= scale;
+    return scaled;
 }
 
-bool font::load_glyph(char c, float size)
+bool font::load_glyph(codepoint_t codepoint)
 {
-    uint32_t codepoint = to_utf32(&c);
-    
-    FT_Library library;
-    FT_Face face;
-    if (!load_face(d_filename, size, &library, &face)) {
+    if (!d_face) {
         return false;
     }
 
-    FT_UInt glyph_index = FT_Get_Char_Index(face, (FT_ULong)codepoint);
-    FT_Int32 flags = FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT;
-    if (FT_Load_Glyph(face, glyph_index, flags)) {
-        FT_Done_Face(face);
-        FT_Done_FreeType(library);
+    FT_UInt glyph_index = FT_Get_Char_Index(d_face, (FT_ULong)codepoint);
+    if (FT_Load_Glyph(d_face, glyph_index, FT_LOAD_DEFAULT)) {
+        return false;
+    }
+
+    FT_GlyphSlot slot = d_face->glyph;
+
+    glyph glyph;
+    glyph.codepoint = codepoint;
+    glyph.advance = glm::vec2{slot->advance.x, slot->advance.y} / HRESf;
+
+    // Whitespace has nothing to draw, only an advance.
+    if (slot->outline.n_points == 0) {
+        add_glyph(glyph);
+        return true;
+    }
+
+    // Rendering to a bitmap first has FreeType build the distance field from that rather
+    // than the outline, which copes better with overlapping contours.
+    if (FT_Render_Glyph(slot, FT_RENDER_MODE_NORMAL) || FT_Render_Glyph(slot, FT_RENDER_MODE_SDF)) {
         return false;
     }
 
-    FT_GlyphSlot slot = face->glyph;
     FT_Bitmap bitmap  = slot->bitmap;
     auto region = d_atlas.get_region(bitmap.width, bitmap.rows);
     if (region.x < 0) {
         spkt::log::error("Texture atlas is full!");
-        FT_Done_Face(face);
-        FT_Done_FreeType(library);
         return false;
     }
 
     d_atlas.set_region(region, bitmap.buffer);
 
-    auto& font = d_font_data[size];
-    glyph& glyph = font.glyphs[codepoint];
-
-    glyph.codepoint = codepoint;
-    glyph.width     = slot->bitmap.width;
-    glyph.height    = slot->bitmap.rows;
-    glyph.offset    = {slot->bitmap_left, slot->bitmap_top};
+    // The bitmap is grown by the spread on every side, so take it off again to leave the
+    // metrics describing the outline.
+    glyph.width     = (float)bitmap.width - 2.0f * SPREAD;
+    glyph.height    = (float)bitmap.rows - 2.0f * SPREAD;
+    glyph.offset    = {slot->bitmap_left + SPREAD, slot->bitmap_top - SPREAD};
+    glyph.padding   = (float)SPREAD;
     glyph.texture.x = region.x / (float)d_atlas.width();
     glyph.texture.y = region.y / (float)d_atlas.height();
-    glyph.texture.z = glyph.width / (float)d_atlas.width();
-    glyph.texture.w = glyph.height / (float)d_atlas.height();
-    glyph.advance = glm::vec2{slot->advance.x, slot->advance.y} / HRESf;
+    glyph.texture.z = bitmap.width / (float)d_atlas.width();
+    glyph.texture.w = bitmap.rows / (float)d_atlas.height();
+
+    add_glyph(glyph);
+    return true;
+}
+
+float font::kerning(codepoint_t left, codepoint_t right)
+{
+    const auto key = kerning_key(left, right);
+    if (auto it = d_kernings.find(key); it != d_kernings.end()) {
+        return it->second;
+    }
+
+    // Looked up on first use rather than for every pair of loaded glyphs, and remembered
+    // even when there is none.
+    float kerning = 0.0f;
+    if (d_face && FT_HAS_KERNING(d_face)) {
+        FT_Vector vector;
+        FT_UInt left_index = FT_Get_Char_Index(d_face, (FT_ULong)left);
+        FT_UInt right_index = FT_Get_Char_Index(d_face, (FT_ULong)right);
+        if (!FT_Get_Kerning(d_face, left_index, right_index, FT_KERNING_UNFITTED, &vector)) {
+            kerning = vector.x / (HRESf * HRESf);
+        }
+    }
+
+    d_kernings.emplace(key, kerning);
+    return kerning;
+}
 
-    generate_kerning(font.glyphs, font.kernings, &library, &face);
+float font::get_kerning(codepoint_t left, codepoint_t right, float size)
+{
+    return kerning(left, right) * size / REFERENCE_SIZE;
+}
+
+void font::prebake(std::string_view characters)
+{
+    if (!d_face) {
+        return;
+    }
+
+    std::vector<codepoint_t> charset;
+    for (char c = ' '; c <= '~'; ++c) {
+        charset.push_back((codepoint_t)c);
+    }
+    for (codepoint_t codepoint : utf8_view(characters)) {
+        charset.push_back(codepoint);
+    }
+    std::ranges::sort(charset);
+    charset.erase(std::unique(charset.begin(), charset.end()), charset.end());
+
+    std::uint64_t key = fnv1a({reinterpret_cast<const char*>(d_file_data.data()), d_file_data.size()});
+    key = fnv1a(std::format("{}:{}:{}:{}x{}", CACHE_VERSION, REFERENCE_SIZE, SPREAD, d_atlas.width(), d_atlas.height()), key);
+    key = fnv1a({reinterpret_cast<const char*>(charset.data()), charset.size() * sizeof(codepoint_t)}, key);
+
+    if (d_glyphs.empty() && load_cache(key)) {
+        return;
+    }
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(library);
+    for (codepoint_t left : charset) {
+        if (!d_glyphs.contains(left)) {
+            load_glyph(left);
+        }
+        for (codepoint_t right : charset) {
+            kerning(left, right);
+        }
+    }
+    save_cache(key);
+}
+
+bool font::load_cache(std::uint64_t key)
+{
+    std::ifstream stream(cache_file(key), std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+
+    std::uint32_t magic = 0;
+    stream.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    if (!stream || magic != CACHE_MAGIC) {
+        return false;
+    }
+
+    std::vector<glm::ivec3> nodes;
+    std::vector<glyph> glyphs;
+    std::vector<kerning_entry> kernings;
+    std::vector<unsigned char> pixels;
+    if (!read_vector(stream, nodes) || !read_vector(stream, glyphs)
+        || !read_vector(stream, kernings) || !read_vector(stream, pixels)) {
+        log::warn("Font cache for '{}' is truncated", d_filename);
+        return false;
+    }
+
+    if (!d_atlas.restore(std::move(nodes), std::move(pixels))) {
+        return false;
+    }
+    for (const auto& glyph : glyphs) {
+        add_glyph(glyph);
+    }
+    for (const auto& entry : kernings) {
+        d_kernings.emplace(kerning_key(entry.left, entry.right), entry.kerning);
+    }
     return true;
 }
 
-float font::get_kerning(char left, char right, float size)
+void font::save_cache(std::uint64_t key) const
 {
-    auto& font = d_font_data[size];
+    std::error_code ec;
+    std::filesystem::create_directories(CACHE_DIRECTORY, ec);
+    if (ec) {
+        log::warn("Could not create font cache directory: {}", ec.message());
+        return;
+    }
 
-    uint32_t l = to_utf32(&left);
-    uint32_t r = to_utf32(&right);
+    std::vector<glyph> glyphs;
+    glyphs.reserve(d_glyphs.size());
+    for (const auto& [codepoint, glyph] : d_glyphs) {
+        glyphs.push_back(glyph);
+    }
 
-    auto it = font.kernings.find(std::make_pair(l, r));
-    if (it != font.kernings.end()) {
-        return it->second;
+    std::vector<kerning_entry> kernings;
+    kernings.reserve(d_kernings.size());
+    for (const auto& [key, kerning] : d_kernings) {
+        kernings.push_back({(codepoint_t)(key >> 32), (codepoint_t)key, kerning});
     }
 
-    return 0.0f;
+    std::ofstream stream(cache_file(key), std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(&CACHE_MAGIC), sizeof(CACHE_MAGIC));
+    write_range(stream, d_atlas.nodes());
+    write_range(stream, glyphs);
+    write_range(stream, kernings);
+    write_range(stream, d_atlas.pixels());
 }
 
 float font::text_width(std::string_view text, float size)
 {
-    float width = 0;
-    for (int i = 0; i != text.size(); ++i) {
-        auto glyph = get_glyph(text[i], size);
+    return layout(text, size).width;
+}
 
-        if (i > 0) {
-            width += get_kerning(text[i-1], text[i], size);
+const text_layout& font::layout(std::string_view text, float size)
+{
+    const std::size_t key = std::hash<std::string_view>{}(text) ^ (std::hash<float>{}(size) * 0x9e3779b97f4a7c15ull);
+    if (d_layout_caching) {
+        if (auto it = d_layout_index.find(key); it != d_layout_index.end()) {
+            const auto& [_, cached] = *it->second;
+            if (cached.size == size && cached.text == text) {
+                ++d_layout_stats.hits;
+                d_layouts.splice(d_layouts.begin(), d_layouts, it->second);
+                return cached;
+            }
+        }
+    }
+    ++d_layout_stats.misses;
+
+    text_layout layout;
+    layout.text = text;
+    layout.size = size;
+    layout.quads.reserve(text.size());
+
+    glm::vec2 pen{0.0f, 0.0f};
+    bool empty = true;
+    codepoint_t previous = 0;
+    glyph glyph;
+    for (codepoint_t codepoint : utf8_view(text)) {
+        glyph = get_glyph(codepoint, size);
+
+        if (empty) {
+            layout.first = glyph;
+            empty = false;
+        } else {
+            pen.x += get_kerning(previous, codepoint, size);
+        }
+        previous = codepoint;
+
+        if (glyph.width > 0.0f && glyph.height > 0.0f) {
+            layout.quads.push_back({
+                .position = {
+                    pen.x + glyph.offset.x - glyph.padding,
+                    pen.y - glyph.offset.y - glyph.padding,
+                    glyph.width + 2.0f * glyph.padding,
+                    glyph.height + 2.0f * glyph.padding
+                },
+                .texture = glyph.texture
+            });
         }
 
-        width += glyph.advance.x;
+        pen += glyph.advance;
     }
 
-    glyph first = get_glyph(text.front(), size);
-    width -= first.offset.x;
+    // The last glyph's advance is swapped for its extent, so the width covers the ink.
+    if (!empty) {
+        layout.width = pen.x - layout.first.offset.x + glyph.width + glyph.offset.x - glyph.advance.x;
+    }
 
-    glyph last = get_glyph(text.back(), size);
-    width += last.width;
-    width += last.offset.x;
-    width -= last.advance.x;
+    if (!d_layout_caching) {
+        d_uncached_layout = std::move(layout);
+        return d_uncached_layout;
+    }
 
-    return width;
+    // A different string with the same key replaces the existing entry.
+    if (auto it = d_layout_index.find(key); it != d_layout_index.end()) {
+        d_layouts.splice(d_layouts.begin(), d_layouts, it->second);
+        d_layouts.front().second = std::move(layout);
+        return d_layouts.front().second;
+    }
+
+    if (d_layouts.size() >= MAX_CACHED_LAYOUTS) {
+        d_layout_index.erase(d_layouts.back().first);
+        d_layouts.pop_back();
+    }
+    d_layouts.emplace_front(key, std::move(layout));
+    d_layout_index.emplace(key, d_layouts.begin());
+    return d_layouts.front().second;
 }
 
 }
\ No newline at end of file
@@ -1,46 +1,132 @@
 #pragma once
 #include <sprocket/ui/font/font_atlas.h>
 #include <sprocket/ui/font/glyph.h>
-#include <sprocket/utility/hashing.h>
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+// FreeType handles, kept opaque so that its headers stay out of this one.
+struct FT_LibraryRec_;
+struct FT_FaceRec_;
+
 namespace spkt {
 
 using codepoint_t = std::uint32_t;
-using kerning_map = std::unordered_map<std::pair<codepoint_t, codepoint_t>, float, spkt::hash_pair>;
+using kerning_map = std::unordered_map<std::uint64_t, float>; // Keyed by the pair, see kerning_key
 using glyph_map = std::unordered_map<codepoint_t, spkt::glyph>;
 
-struct sized_font_data
+// A glyph placed relative to where the pen starts, grown to cover its distance field.
+struct glyph_quad
+{
+    glm::vec4 position; // x, y, width, height
+    glm::vec4 texture;
+};
+
+// A string laid out with the pen starting at the origin, see font::layout.
+struct text_layout
 {
-    glyph_map   glyphs;
-    kerning_map kernings;
+    std::string text; // Compared on lookup, since layouts are keyed by a hash
+    float       size = 0.0f;
+
+    std::vector<glyph_quad> quads; // Only for glyphs with something to draw
+
+    float       width = 0.0f; // As given by text_width
+    spkt::glyph first;        // Centred text is positioned by its first glyph
 };
 
+struct text_layout_stats
+{
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+};
+
+// Glyphs are rasterised once, at a reference size, as signed distance fields. These are
+// drawn at any size by scaling the glyph metrics and thresholding the distance in the
+// shader, so the atlas holds one copy of each glyph however many sizes are used.
 class font
 {
     std::string d_filename;
-    
+
     spkt::font_atlas d_atlas;
-    std::unordered_map<float, sized_font_data> d_font_data;
 
-    bool load_glyph(char c, float size);
+    // Both at the reference size, and scaled when returned.
+    glyph_map   d_glyphs;
+    kerning_map d_kernings; // Memoised as pairs are looked up, including pairs with none
+
+    // Loaded ASCII glyphs are also found here, so the common case skips the hash lookup.
+    // Elements of an unordered_map are never moved, so these stay valid.
+    std::array<const spkt::glyph*, 128> d_ascii_glyphs = {};
+
+    // Cached layouts with the most recently used first, each with its key, which is a
+    // hash of the string and size. The least recently used is evicted when the cache is
+    // full, so text that changes every frame only displaces layouts that are not in use.
+    using layout_list = std::list<std::pair<std::size_t, text_layout>>;
+    layout_list                                            d_layouts;
+    std::unordered_map<std::size_t, layout_list::iterator> d_layout_index;
+    text_layout_stats                                      d_layout_stats;
+    bool                                                   d_layout_caching = true;
+    text_layout                                            d_uncached_layout;
+
+    FT_LibraryRec_*            d_library = nullptr;
+    FT_FaceRec_*               d_face = nullptr;
+    std::vector<unsigned char> d_file_data; // Must outlive the face
+
+    bool load_glyph(codepoint_t codepoint);
+    void add_glyph(const spkt::glyph& glyph);
+
+    // Returns the glyph at the reference size, loading it if needed, or null if the font
+    // does not have it.
+    const spkt::glyph* find_glyph(codepoint_t codepoint);
+
+    // The kerning between the pair at the reference size.
+    float kerning(codepoint_t left, codepoint_t right);
+
+    // The cache holds the atlas along with the glyphs and kerning in it. Loading replaces
+    // them, so is only done while no glyphs have been loaded.
+    bool load_cache(std::uint64_t key);
+    void save_cache(std::uint64_t key) const;
+
+    font(const font&) = delete;
+    font& operator=(const font&) = delete;
 
 public:
     font(const std::string& filename);
+    ~font();
+
+    // Loads the printable ASCII characters along with the given UTF-8 ones, and the kerning
+    // between every pair of them, so that text using only these never has to rasterise
+    // glyphs while drawing. The result is cached on disk, keyed by the font file and the
+    // characters, so later runs restore it with a single upload.
+    void prebake(std::string_view characters = {});
 
-    spkt::glyph get_glyph(char c, float size);
-    float get_kerning(char left, char right, float size);
+    spkt::glyph get_glyph(codepoint_t codepoint, float size);
+    float get_kerning(codepoint_t left, codepoint_t right, float size);
 
     void bind(int slot) const { d_atlas.bind(slot); }
 
+    // Text is UTF-8 here and in layout.
     float text_width(std::string_view text, float size);
 
+    // Lays out the string, or returns the layout from an earlier call with the same string
+    // and size. Glyphs never move within the atlas so layouts stay valid, but once the
+    // cache is full the least recently used layout is dropped for each new one.
+    // The reference is valid until the next call.
+    const text_layout& layout(std::string_view text, float size);
+
+    const text_layout_stats& layout_stats() const { return d_layout_stats; }
+    void reset_layout_stats() { d_layout_stats = {}; }
+
+    // While disabled, every call to layout lays the string out again.
+    void set_layout_caching(bool enabled) { d_layout_caching = enabled; }
+
     const spkt::texture* get_atlas() const { return d_atlas.get_atlas(); }
 };
 
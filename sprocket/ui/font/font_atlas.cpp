@@ -5,12 +5,15 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
 #include <limits>
+#include <utility>
 
 namespace spkt {
 
 font_atlas::font_atlas(int width, int height)
     : d_texture(std::make_unique<texture>(width, height, texture_channels::RED))
+    , d_pixels((std::size_t)width * height, 0)
 {
     // We want a one pixel border around the whole atlas to avoid any
     // artefact when sampling texture
@@ -26,6 +29,22 @@ void font_atlas::set_region(
     assert(region.x + region.z < d_texture->width());
     assert(region.y + region.w < d_texture->height());
     d_texture->set_subtexture(region, data);
+
+    for (int row = 0; row != region.w; ++row) {
+        const std::size_t offset = (std::size_t)(region.y + row) * width() + region.x;
+        std::memcpy(d_pixels.data() + offset, data + (std::size_t)row * region.z, region.z);
+    }
+}
+
+bool font_atlas::restore(std::vector<glm::ivec3> nodes, std::vector<unsigned char> pixels)
+{
+    if (nodes.empty() || pixels.size() != d_pixels.size()) {
+        return false;
+    }
+    d_nodes = std::move(nodes);
+    d_pixels = std::move(pixels);
+    d_texture->set_subtexture({0, 0, (int)width(), (int)height()}, d_pixels.data());
+    return true;
 }
 
 int font_atlas::fit(int index, int width, int height)
@@ -6,6 +6,7 @@
 
 #include <cstdlib>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace spkt {
@@ -15,6 +16,9 @@ class font_atlas
     std::vector<glm::ivec3>  d_nodes;
     std::unique_ptr<texture> d_texture;
 
+    // A copy of the texture's contents, so that the atlas can be saved.
+    std::vector<unsigned char> d_pixels;
+
     int fit(int index, int width, int height);
 
 public:
@@ -23,6 +27,12 @@ public:
     glm::ivec4 get_region(std::size_t width, std::size_t height);
     void set_region(const glm::ivec4& region, const unsigned char* data);
 
+    // The packing state and contents, which restore puts back in a single upload. Returns
+    // false if they do not fit this atlas.
+    const std::vector<glm::ivec3>& nodes() const { return d_nodes; }
+    std::span<const unsigned char> pixels() const { return d_pixels; }
+    bool restore(std::vector<glm::ivec3> nodes, std::vector<unsigned char> pixels);
+
     std::size_t width() const { return d_texture->width(); }
     std::size_t height() const { return d_texture->height(); }
 
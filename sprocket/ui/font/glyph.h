@@ -9,11 +9,16 @@ struct glyph
 {
     std::uint32_t codepoint = -1;
 
-    std::size_t width  = 0;
-    std::size_t height = 0;
+    // The extent of the glyph's outline, which the metrics are relative to.
+    float width  = 0.0f;
+    float height = 0.0f;
 
-    glm::ivec2 offset = {0, 0};
+    glm::vec2 offset = {0.0f, 0.0f};
     glm::vec2 advance = {0.0f, 0.0f};
+
+    // The distance field extends this far beyond each side of the outline. The texture
+    // coordinates cover the field, so quads must be grown by this much to match.
+    float padding = 0.0f;
     glm::vec4 texture = {0.0f, 0.0f, 0.0f, 0.0f};
 };
 
@@ -3,6 +3,7 @@
 #include <sprocket/core/events.h>
 #include <sprocket/core/input_codes.h>
 #include <sprocket/core/window.h>
+#include <sprocket/graphics/gpu_profiler.h>
 #include <sprocket/graphics/render_context.h>
 
 #include <glad/glad.h>
@@ -131,7 +132,7 @@ void set_key_mappings()
 std::unique_ptr<texture> set_font(std::string_view font, float size)
 {
     ImGuiIO& io = ImGui::GetIO();    
-    io.FontDefault = io.Fonts->AddFontFromFileTTF("Resources/Fonts/Calibri.ttf", 15.0f);
+    io.FontDefault = io.Fonts->AddFontFromFileTTF("resources/Fonts/CALIBRI.TTF", 15.0f);
     unsigned char* data;
     int width, height;
     io.Fonts->GetTexDataAsRGBA32(&data, &width, &height);
@@ -139,7 +140,7 @@ std::unique_ptr<texture> set_font(std::string_view font, float size)
     auto texture = std::make_unique<spkt::texture>(spkt::texture_data{
         .width = width,
         .height = height,
-        .bytes = {span_data.begin(), span_data.end()}
+        .bytes = spkt::pixel_buffer::copy_of(span_data)
     });
     io.Fonts->TexID = reinterpret_cast<void*>(texture->id());
     return texture;
@@ -163,7 +164,7 @@ void bind_imgui_vbo(std::uint32_t vbo)
 }
 
 imgui_ui::imgui_ui(window* window)
-    : d_shader("Resources/Shaders/DevGUI.vert", "Resources/Shaders/DevGUI.frag")
+    : d_shader("resources/Shaders/DevGUI.vert", "resources/Shaders/DevGUI.frag")
     , d_font_atlas(nullptr)
     , d_vtx_buffer()
     , d_idx_buffer()
@@ -177,7 +178,7 @@ imgui_ui::imgui_ui(window* window)
     set_key_mappings();
     set_dark_theme();
 
-    d_font_atlas = set_font("Resources/Fonts/Calibri.ttf", 15.0f);
+    d_font_atlas = set_font("resources/Fonts/CALIBRI.TTF", 15.0f);
 
     ImGuiIO& io = ImGui::GetIO();
     io.DisplaySize = ImVec2((float)window->width(), (float)window->height());
@@ -266,6 +267,7 @@ void imgui_ui::end_frame()
 {
     ImGui::Render();
 
+    spkt::gpu_scope scope("imgui");
     spkt::render_context rc;  
     rc.alpha_blending(true);
     rc.face_culling(false);
@@ -3,6 +3,7 @@
 #include <sprocket/core/window.h>
 #include <sprocket/core/events.h>
 #include <sprocket/core/input_codes.h>
+#include <sprocket/utility/utf8.h>
 
 #include <fmt/core.h>
 
@@ -49,8 +50,9 @@ template <typename T> T Interpolate(
 simple_ui::simple_ui(window* window)
     : d_window(window)
     , d_engine(window)
-    , d_font("Resources/Fonts/Coolvetica.ttf")
+    , d_font("resources/Fonts/Coolvetica.ttf")
 {
+    d_font.prebake();
 }
 
 void simple_ui::on_event(event& event)
@@ -140,13 +142,11 @@ void simple_ui::text_modifiable(
     cmd.region = info.quad;
     cmd.text_font = &d_font;
 
-    for (int key : info.key_presses) {
-        if (key == Keyboard::BACKSPACE) {
-            if (text->size() > 0) {
-                text->pop_back();
-            }
-        } else {
-            text->push_back(static_cast<char>(key));
+    for (const auto& press : info.key_presses) {
+        if (press.typed) {
+            append_utf8(*text, press.codepoint);
+        } else if (press.key == Keyboard::BACKSPACE) {
+            pop_back_utf8(*text);
         }
     }
 
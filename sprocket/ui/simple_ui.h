@@ -1,5 +1,5 @@
 #pragma once
-#include <sprocket/ui/Font/font.h>
+#include <sprocket/ui/font/font.h>
 #include <sprocket/ui/ui_engine.h>
 
 #include <glm/glm.hpp>
@@ -36,6 +36,9 @@ public:
     void set_theme(const spkt::simple_ui_theme& theme) { d_theme = theme; }
 
     spkt::font* get_font() { return &d_font; }
+
+    // Draw commands and draw calls in the last frame.
+    const spkt::ui_render_stats& render_stats() const { return d_engine.last_frame_stats(); }
     
     void on_event(spkt::event& event);
     void on_update(double dt);
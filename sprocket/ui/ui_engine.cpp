@@ -4,9 +4,11 @@
 #include <sprocket/core/input_codes.h>
 #include <sprocket/core/log.h>
 #include <sprocket/core/window.h>
+#include <sprocket/graphics/gpu_profiler.h>
 #include <sprocket/graphics/render_context.h>
-#include <sprocket/ui/Font/font.h>
-#include <sprocket/ui/Font/glyph.h>
+#include <sprocket/graphics/render_stats.h>
+#include <sprocket/ui/font/font.h>
+#include <sprocket/ui/font/glyph.h>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -21,6 +23,13 @@
 namespace spkt {
 namespace {
 
+// The vertices reserved for each frame up front. The buffer grows to fit larger frames.
+constexpr std::size_t INITIAL_VERTICES = 16384;
+
+// Texture coordinates for geometry with no texture. The shader outputs the vertex colour
+// for these, so untextured quads can be drawn alongside any texture.
+const glm::vec2 UNTEXTURED = {-1.0f, -1.0f};
+
 bool is_in_region(const glm::vec2& pos, const glm::vec4& quad)
 {
     float x = quad.x;
@@ -32,10 +41,11 @@ bool is_in_region(const glm::vec2& pos, const glm::vec4& quad)
 
 spkt::texture_data get_white_data()
 {
+    static constexpr unsigned char white[] = {0xff, 0xff, 0xff, 0xff};
     return {
         .width = 1,
         .height = 1,
-        .bytes = {0xff, 0xff, 0xff, 0xff}
+        .bytes = spkt::pixel_buffer::copy_of(white)
     };
 }
 
@@ -79,6 +89,9 @@ void draw_command::add_text(std::string_view text,
     float size = properties.size;
     glm::vec4 colour = properties.colour;
 
+    // Laid out relative to the pen, so cached layouts are reused wherever the text is.
+    const auto& layout = text_font->layout(text, size);
+
     glm::vec2 pen{quad.x, quad.y};
 
     if (alignment == alignment::LEFT) {
@@ -88,34 +101,25 @@ void draw_command::add_text(std::string_view text,
         pen.x += quad.z - 5.0f;
         pen.y += size;
     } else {
-        float textWidth = text_font->text_width(text, size);
-        spkt::glyph first = text_font->get_glyph(text.front(), size);
+        const spkt::glyph& first = layout.first;
         pen.y += (quad.w - first.height) / 2.0f;
-        pen.x += (quad.z - textWidth) / 2.0f;
+        pen.x += (quad.z - layout.width) / 2.0f;
         pen.x -= first.offset.x;
         pen.y += first.offset.y;
     }
 
-    for (std::size_t i = 0; i != text.size(); ++i) {
-        auto glyph = text_font->get_glyph(text[i], size);
-
-        if (i > 0) {
-            pen.x += text_font->get_kerning(text[i-1], text[i], size);
-        }
-
-        float xPos = pen.x + glyph.offset.x;
-        float yPos = pen.y - glyph.offset.y;
+    for (const auto& glyph : layout.quads) {
+        float xPos = pen.x + glyph.position.x;
+        float yPos = pen.y + glyph.position.y;
 
-        float width = glyph.width;
-        float height = glyph.height;
+        float width = glyph.position.z;
+        float height = glyph.position.w;
 
         float x = glyph.texture.x;
         float y = glyph.texture.y;
         float w = glyph.texture.z;
         float h = glyph.texture.w;
 
-        pen += glyph.advance;
-
         std::uint32_t index = text_vertices.size();
         text_vertices.push_back({{xPos,         yPos},          colour, {x,     y    }});
         text_vertices.push_back({{xPos + width, yPos},          colour, {x + w, y    }});
@@ -133,9 +137,13 @@ void draw_command::add_text(std::string_view text,
 
 ui_engine::ui_engine(spkt::window* window)
     : d_window(window)
-    , d_shader("Resources/Shaders/SimpleUI.vert",
-               "Resources/Shaders/SimpleUI.frag")
+    , d_shader("resources/Shaders/SimpleUI.vert",
+               "resources/Shaders/SimpleUI.frag")
+    , d_text_shader("resources/Shaders/SimpleUI.vert",
+                    "resources/Shaders/SimpleUI.frag",
+                    {"DISTANCE_FIELD"})
     , d_white(get_white_data())
+    , d_vertices(INITIAL_VERTICES)
 {
 }
 
@@ -217,18 +225,18 @@ void ui_engine::on_event(spkt::event& event)
 {
     if (d_focused != 0 && !event.is_consumed()) {
         if (auto data = event.get_if<keyboard_typed_event>()) {
-            d_key_presses.push_back(data->key);
+            d_key_presses.push_back({.typed = true, .codepoint = data->key});
             event.consume();
         }
         else if (auto data = event.get_if<keyboard_pressed_event>()) {
             if (data->key == Keyboard::BACKSPACE) {
-                d_key_presses.push_back(Keyboard::BACKSPACE);
+                d_key_presses.push_back({.key = Keyboard::BACKSPACE});
                 event.consume();
             }
         }
         else if (auto data = event.get_if<keyboard_held_event>()) {
             if (data->key == Keyboard::BACKSPACE) {
-                d_key_presses.push_back(Keyboard::BACKSPACE);
+                d_key_presses.push_back({.key = Keyboard::BACKSPACE});
                 event.consume();
             }
         }
@@ -352,6 +360,33 @@ void ui_engine::end_frame()
 
     d_key_presses.clear();
 
+    d_frame_vertices.clear();
+    d_frame_indices.clear();
+    d_batches.clear();
+    d_stats = {};
+
+    for (const auto& panelHash : d_panel_order) {
+        const auto& panel = d_panels[panelHash];
+
+        const auto add_command = [&](const draw_command& cmd) {
+            batch_geometry(cmd.vertices, cmd.indices, cmd.texture, nullptr, cmd.region);
+            if (cmd.text_font) {
+                batch_geometry(cmd.text_vertices, cmd.text_indices, nullptr, cmd.text_font, cmd.region);
+            }
+            ++d_stats.commands;
+        };
+
+        add_command(panel.main_command);
+        for (const auto& cmd : panel.extra_commands) {
+            add_command(cmd);
+        }
+    }
+
+    if (d_batches.empty()) {
+        return;
+    }
+
+    spkt::gpu_scope scope("ui");
     spkt::render_context rc;
     rc.alpha_blending(true);
     rc.face_culling(false);
@@ -364,16 +399,53 @@ void ui_engine::end_frame()
     // right be (width, height). It flips the y-axis since OpenGL treats the bottom
     // left as (0, 0).
     const auto proj = glm::ortho(0.0f, w, h, 0.0f);
+    d_text_shader.bind();
+    d_text_shader.load("u_proj_matrix", proj);
     d_shader.bind();
     d_shader.load("u_proj_matrix", proj);
 
-    for (const auto& panelHash : d_panel_order) {
-        const auto& panel = d_panels[panelHash];
+    // The whole frame is uploaded at once. Batches index from their own first vertex,
+    // which is offset by where this frame's vertices start in the streaming buffer.
+    d_vertices.next_frame();
+    const auto allocation = d_vertices.allocate(d_frame_vertices.size());
+    std::ranges::copy(d_frame_vertices, allocation.elements.begin());
+    d_indices.set_data(d_frame_indices);
 
-        execute_command(panel.main_command);
-        for (const auto& cmd : panel.extra_commands) {
-            execute_command(cmd);
+    d_vertices.bind();
+    d_indices.bind();
+
+    const spkt::shader* bound = &d_shader;
+    for (const auto& batch : d_batches) {
+        if (batch.region.has_value()) {
+            rc.set_scissor_window(*batch.region);
+        } else {
+            rc.scissor_testing(false);
+        }
+
+        const spkt::shader* shader = batch.font ? &d_text_shader : &d_shader;
+        if (shader != bound) {
+            shader->bind();
+            bound = shader;
+        }
+
+        if (batch.font) {
+            batch.font->bind(0);
+        } else {
+            const spkt::texture* texture = batch.texture ? batch.texture : &d_white;
+            texture->bind(0);
+            d_shader.load("texture_channels", texture->channels() == texture_channels::RED ? 1 : 4);
         }
+
+        glDrawElementsBaseVertex(
+            GL_TRIANGLES,
+            (GLsizei)batch.index_count,
+            GL_UNSIGNED_INT,
+            (void*)(batch.first_index * sizeof(std::uint32_t)),
+            (GLint)(allocation.first + batch.base_vertex)
+        );
+        SPKT_RECORD_RENDER_STAT(draw_calls, 1);
+        SPKT_RECORD_RENDER_STAT(triangles, batch.index_count / 3);
+        ++d_stats.draw_calls;
     }
 }
 
@@ -415,33 +487,46 @@ void ui_engine::submit_draw_command(const draw_command& cmd)
     d_current_panel->extra_commands.emplace_back(cmd);
 }
 
-void ui_engine::execute_command(const draw_command& cmd)
+void ui_engine::batch_geometry(std::span<const spkt::ui_vertex> vertices,
+                               std::span<const std::uint32_t> indices,
+                               const spkt::texture* texture,
+                               spkt::font* font,
+                               const std::optional<glm::vec4>& region)
 {
-    spkt::render_context rc;
-    if (cmd.region.has_value()) {
-        rc.set_scissor_window(*cmd.region);
+    if (indices.empty()) {
+        return;
     }
 
-    if (cmd.texture) {
-        cmd.texture->bind(0);
-    } else {
-        d_white.bind(0);
+    const bool untextured = !texture && !font;
+    const std::size_t first_vertex = d_frame_vertices.size();
+    d_frame_vertices.insert(d_frame_vertices.end(), vertices.begin(), vertices.end());
+    if (untextured) {
+        for (auto& vertex : d_frame_vertices | std::views::drop(first_vertex)) {
+            vertex.textureCoords = UNTEXTURED;
+        }
     }
 
-    d_vertices.bind();
-    d_indices.bind();
+    batch* current = d_batches.empty() ? nullptr : &d_batches.back();
+    const bool compatible = current && current->region == region && (
+        untextured || current->untextured() || (current->texture == texture && current->font == font)
+    );
 
-    d_vertices.set_data(cmd.vertices);
-    d_indices.set_data(cmd.indices);
-    glDrawElements(GL_TRIANGLES, (int)d_indices.size(), GL_UNSIGNED_INT, nullptr);
+    if (!compatible) {
+        current = &d_batches.emplace_back();
+        current->region = region;
+        current->first_index = d_frame_indices.size();
+        current->base_vertex = first_vertex;
+    }
+    if (current->untextured()) {
+        current->texture = texture;
+        current->font = font;
+    }
 
-    if (cmd.text_font) {
-        cmd.text_font->bind(0);
-        d_shader.load("texture_channels", 1);
-        d_vertices.set_data(cmd.text_vertices);
-        d_indices.set_data(cmd.text_indices);
-        glDrawElements(GL_TRIANGLES, (int)d_indices.size(), GL_UNSIGNED_INT, nullptr);
+    const auto offset = (std::uint32_t)(first_vertex - current->base_vertex);
+    for (std::uint32_t index : indices) {
+        d_frame_indices.push_back(index + offset);
     }
+    current->index_count += indices.size();
 }
 
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <chrono>
 #include <deque>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
@@ -102,6 +103,16 @@ struct widget_times
     double unfocused_time = 0.0;
 };
 
+// Keyboard input for the focused widget. Typed text and editing keys share one sequence
+// so that they apply in the order they happened, but are told apart by the flag since a
+// typed codepoint can have the same value as a key code.
+struct key_press
+{
+    bool          typed = false; // Whether this is typed text rather than an editing key
+    std::uint32_t codepoint = 0; // The typed codepoint
+    int           key = 0;       // The editing key, such as Keyboard::BACKSPACE
+};
+
 struct widget_info
 // When registering a new widget with the UIEngine, the callers gets
 // this struct back. It contains, in seconds, the amount of time that
@@ -124,24 +135,53 @@ struct widget_info
 
     // The keys pressed since the last frame. This is guaranteed to be empty
     // if the current widget is not focused.
-    std::vector<int> key_presses;
+    std::vector<key_press> key_presses;
 
     // The region of the widget converted to screen space coords.
     glm::vec4 quad;
 };
 
+struct ui_render_stats
+{
+    std::size_t commands   = 0;
+    std::size_t draw_calls = 0;
+};
+
 class ui_engine
 {
+    // A run of consecutive geometry drawn with the same texture and scissor region.
+    // Untextured geometry can join any batch, and a batch with only untextured geometry
+    // takes the texture of the first textured geometry added to it.
+    struct batch
+    {
+        const spkt::texture*     texture = nullptr;
+        spkt::font*              font = nullptr; // Drawn with the distance field shader
+        std::optional<glm::vec4> region;
+
+        std::size_t first_index = 0;
+        std::size_t index_count = 0;
+        std::size_t base_vertex = 0; // Relative to the start of the frame's vertices
+
+        bool untextured() const { return !texture && !font; }
+    };
+
     spkt::window* d_window;
 
     spkt::texture d_white;
 
-    // Rendering code    
+    // Rendering code
     spkt::shader d_shader;
-    
-    spkt::vertex_buffer<spkt::ui_vertex> d_vertices;
-    spkt::index_buffer<std::uint32_t>    d_indices;
-    
+    spkt::shader d_text_shader; // The distance field variant, for font atlases
+
+    // All panels are drawn from one stream of vertices and one index buffer per frame.
+    spkt::streaming_buffer<spkt::ui_vertex>                 d_vertices;
+    spkt::index_buffer<std::uint32_t, buffer_usage::STREAM> d_indices;
+
+    std::vector<spkt::ui_vertex> d_frame_vertices;
+    std::vector<std::uint32_t>   d_frame_indices;
+    std::vector<batch>           d_batches;
+    ui_render_stats              d_stats;
+
     // Panel info 
     std::unordered_map<std::size_t, panel> d_panels;
     panel* d_current_panel = nullptr;
@@ -169,14 +209,20 @@ class ui_engine
 
     // A vector of key presses that happened since last frame. This will be
     // given to the currently focused widget.
-    std::vector<int> d_key_presses;
+    std::vector<key_press> d_key_presses;
     bool d_consume_mouse_events = false;
     bool d_mouse_clicked = false;
 
     void mouse_click();
     void mouse_hover();
 
-    void execute_command(const draw_command& cmd);
+    // Appends geometry to the frame's vertices and indices, extending the last batch if
+    // it can be drawn in the same call.
+    void batch_geometry(std::span<const spkt::ui_vertex> vertices,
+                        std::span<const std::uint32_t> indices,
+                        const spkt::texture* texture,
+                        spkt::font* font,
+                        const std::optional<glm::vec4>& region);
 
 public:
     ui_engine(spkt::window* window);
@@ -205,6 +251,10 @@ public:
 
     void start_panel(std::string_view name, glm::vec4* region, panel_type type);
     void end_panel();
+
+    // The number of draw commands submitted by panels, and the draw calls needed for
+    // them, in the last frame.
+    const ui_render_stats& last_frame_stats() const { return d_stats; }
 };
 
 }
\ No newline at end of file
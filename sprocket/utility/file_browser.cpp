@@ -1,13 +1,18 @@
 #include "file_browser.h"
 
+#include <sprocket/core/log.h>
 #include <sprocket/core/window.h>
 
+#ifdef _WIN32
 #include <GLFW/glfw3.h>
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3native.h>
 #include <Windows.h>
+#endif
 
 namespace spkt {
+
+#ifdef _WIN32
 namespace {
 
 void set_ofn(OPENFILENAMEA* ofn, window* window, const char* filter)
@@ -51,4 +56,21 @@ std::optional<std::string> save_file(window* window, const char* filter)
     return std::nullopt;
 }
 
+#else
+
+// There is no native file dialog on other platforms yet.
+std::optional<std::string> open_file(window* window, const char* filter)
+{
+    log::warn("File dialogs are only supported on Windows");
+    return std::nullopt;
+}
+
+std::optional<std::string> save_file(window* window, const char* filter)
+{
+    log::warn("File dialogs are only supported on Windows");
+    return std::nullopt;
+}
+
+#endif
+
 }
\ No newline at end of file
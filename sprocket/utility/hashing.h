@@ -2,6 +2,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include <cstdint>
 #include <utility>
 #include <string_view>
 
@@ -18,4 +19,17 @@ struct hash_pair
     } 
 };
 
+// A 64-bit FNV-1a hash. Unlike std::hash, the result is stable across runs and
+// platforms, so it is suitable for keying data that is persisted to disk. The seed
+// allows hashes to be chained across multiple strings.
+constexpr std::uint64_t fnv1a(std::string_view data, std::uint64_t seed = 0xcbf29ce484222325ull)
+{
+    std::uint64_t hash = seed;
+    for (char c : data) {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
 }
\ No newline at end of file
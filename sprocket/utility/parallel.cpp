@@ -0,0 +1,62 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace spkt {
+
+job_pool::job_pool(std::size_t num_workers)
+{
+    d_workers.reserve(num_workers);
+    for (std::size_t i = 0; i != num_workers; ++i) {
+        d_workers.emplace_back([this](std::stop_token token) { work(token); });
+    }
+}
+
+job_pool& job_pool::shared()
+{
+    static job_pool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void job_pool::work(std::stop_token token)
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(d_mutex);
+            if (!d_wake.wait(lock, token, [&] { return !d_jobs.empty(); })) {
+                return; // Stop was requested
+            }
+            job = std::move(d_jobs.front());
+            d_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void job_pool::push(std::function<void()> job)
+{
+    {
+        std::lock_guard lock(d_mutex);
+        d_jobs.push_back(std::move(job));
+    }
+    d_wake.notify_one();
+}
+
+bool job_pool::try_run_one()
+{
+    std::function<void()> job;
+    {
+        std::lock_guard lock(d_mutex);
+        if (d_jobs.empty()) {
+            return false;
+        }
+        job = std::move(d_jobs.front());
+        d_jobs.pop_front();
+    }
+    job();
+    return true;
+}
+
+}
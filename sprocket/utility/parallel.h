@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace spkt {
+
+// A fixed set of long-lived worker threads that run queued jobs, so that work handed out
+// every frame does not pay for creating and joining threads.
+class job_pool
+{
+    std::mutex                        d_mutex;
+    std::condition_variable_any       d_wake;
+    std::deque<std::function<void()>> d_jobs;
+
+    // Declared last so that the workers are stopped and joined before the queue goes.
+    std::vector<std::jthread> d_workers;
+
+    void work(std::stop_token token);
+
+    job_pool(const job_pool&) = delete;
+    job_pool& operator=(const job_pool&) = delete;
+
+public:
+    explicit job_pool(std::size_t num_workers);
+
+    // The pool used by parallel_for_chunks by default, with a worker for each hardware
+    // thread other than the calling one.
+    static job_pool& shared();
+
+    std::size_t num_workers() const { return d_workers.size(); }
+
+    void push(std::function<void()> job);
+
+    // Runs one queued job on the calling thread, returning false if there were none.
+    // Lets a thread waiting on jobs help with them instead of blocking.
+    bool try_run_one();
+};
+
+// Returns the number of chunks that parallel_for_chunks will split a range of the given
+// size into: at most one per thread, each at least min_chunk_size long.
+inline std::size_t num_parallel_chunks(std::size_t count, std::size_t min_chunk_size, std::size_t num_threads)
+{
+    const std::size_t by_size = std::max<std::size_t>(1, count / std::max<std::size_t>(1, min_chunk_size));
+    return std::min(std::max<std::size_t>(1, num_threads), by_size);
+}
+
+// Splits the index range [0, count) into contiguous chunks and invokes func(begin, end)
+// for each chunk on the pool's workers, returning the results in chunk order. The calling
+// thread processes the final chunk itself and then helps with any chunks still queued.
+// An exception thrown by func is rethrown once every chunk has finished.
+template <typename Func>
+auto parallel_for_chunks(job_pool& pool, std::size_t count, std::size_t min_chunk_size, Func&& func)
+{
+    using result_type = std::invoke_result_t<Func&, std::size_t, std::size_t>;
+
+    const std::size_t num_chunks = num_parallel_chunks(count, min_chunk_size, pool.num_workers() + 1);
+    const std::size_t chunk_size = (count + num_chunks - 1) / num_chunks;
+
+    std::vector<std::optional<result_type>> results(num_chunks);
+    std::vector<std::exception_ptr> errors(num_chunks);
+    const auto run_chunk = [&](std::size_t chunk) {
+        const std::size_t begin = std::min(count, chunk * chunk_size);
+        const std::size_t end = chunk + 1 == num_chunks ? count : std::min(count, begin + chunk_size);
+        try {
+            results[chunk].emplace(func(begin, end));
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    std::latch done(num_chunks - 1);
+    for (std::size_t chunk = 0; chunk + 1 < num_chunks; ++chunk) {
+        pool.push([&, chunk] {
+            run_chunk(chunk);
+            done.count_down();
+        });
+    }
+
+    run_chunk(num_chunks - 1);
+    while (!done.try_wait()) {
+        if (!pool.try_run_one()) {
+            done.wait();
+        }
+    }
+
+    for (const auto& error : errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+
+    std::vector<result_type> chunks;
+    chunks.reserve(num_chunks);
+    for (auto& result : results) {
+        chunks.push_back(std::move(*result));
+    }
+    return chunks;
+}
+
+// As above, using the shared pool.
+template <typename Func>
+auto parallel_for_chunks(std::size_t count, std::size_t min_chunk_size, Func&& func)
+{
+    return parallel_for_chunks(job_pool::shared(), count, min_chunk_size, std::forward<Func>(func));
+}
+
+}
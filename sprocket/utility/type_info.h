@@ -7,7 +7,11 @@ namespace spkt {
 
 template <typename T>
 constexpr std::string_view type_name_raw() {
+#ifdef _MSC_VER
     return __FUNCSIG__;
+#else
+    return __PRETTY_FUNCTION__;
+#endif
 }
 
 template <typename T>
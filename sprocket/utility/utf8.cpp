@@ -0,0 +1,82 @@
+#include "utf8.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Compile-time checks of the UTF-8 helpers in utf8.h; there is no runtime code here.
+
+namespace spkt {
+namespace {
+
+constexpr std::u32string decode(std::string_view text)
+{
+    std::u32string codepoints;
+    for (std::uint32_t codepoint : utf8_view(text)) {
+        codepoints.push_back(codepoint);
+    }
+    return codepoints;
+}
+
+constexpr std::string encode(std::uint32_t codepoint)
+{
+    std::string text;
+    append_utf8(text, codepoint);
+    return text;
+}
+
+constexpr std::string pop_back(std::string_view input)
+{
+    std::string text{input};
+    pop_back_utf8(text);
+    return text;
+}
+
+constexpr bool round_trips(std::uint32_t codepoint)
+{
+    return decode(encode(codepoint)) == std::u32string(1, codepoint);
+}
+
+// Sequences of each length
+static_assert(decode("") == U"");
+static_assert(decode("Az~") == U"Az~");
+static_assert(decode("\xc3\xa9") == U"\u00e9");
+static_assert(decode("\xe2\x82\xac") == U"\u20ac");
+static_assert(decode("\xf0\x9f\x98\x80") == U"\U0001F600");
+static_assert(decode("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z") == U"a\u00e9\u20ac\U0001F600z");
+
+// Malformed input decodes as one replacement character per byte: stray and missing
+// continuation bytes, truncated, overlong and surrogate sequences, and values beyond
+// U+10FFFF.
+static_assert(decode("\x80") == U"\uFFFD");
+static_assert(decode("\xff" "a") == U"\uFFFDa");
+static_assert(decode("\xc3" "A") == U"\uFFFDA");
+static_assert(decode("\xe2\x82") == U"\uFFFD\uFFFD");
+static_assert(decode("\xf0\x9f\x98") == U"\uFFFD\uFFFD\uFFFD");
+static_assert(decode("\xc0\xaf") == U"\uFFFD\uFFFD");
+static_assert(decode("\xe0\x80\xaf") == U"\uFFFD\uFFFD\uFFFD");
+static_assert(decode("\xed\xa0\x80") == U"\uFFFD\uFFFD\uFFFD");
+static_assert(decode("\xf4\x90\x80\x80") == U"\uFFFD\uFFFD\uFFFD\uFFFD");
+
+static_assert(utf8_view("\xe2\x82\xac!").begin().sequence() == "\xe2\x82\xac");
+static_assert(utf8_view("\x80!").begin().sequence() == "\x80");
+
+// Encoding, including the boundaries between sequence lengths
+static_assert(encode(U'A') == "A");
+static_assert(encode(0xE9) == "\xc3\xa9");
+static_assert(encode(0x20AC) == "\xe2\x82\xac");
+static_assert(encode(0x1F600) == "\xf0\x9f\x98\x80");
+static_assert(encode(0xD800) == "\xef\xbf\xbd");
+static_assert(encode(0x110000) == "\xef\xbf\xbd");
+static_assert(round_trips(0x7F) && round_trips(0x80) && round_trips(0x7FF) && round_trips(0x800));
+static_assert(round_trips(0xFFFF) && round_trips(0x10000) && round_trips(0x10FFFF));
+
+// Removing the last codepoint removes all of its bytes
+static_assert(pop_back("") == "");
+static_assert(pop_back("ab") == "a");
+static_assert(pop_back("a\xc3\xa9") == "a");
+static_assert(pop_back("\xc3\xa9\xe2\x82\xac") == "\xc3\xa9");
+static_assert(pop_back("x\xf0\x9f\x98\x80") == "x");
+
+}
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+namespace spkt {
+
+// Decoded in place of each byte that does not start a valid sequence.
+constexpr std::uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+// Iterates over the codepoints of UTF-8 text. Malformed input (stray continuation bytes,
+// truncated or overlong sequences, surrogates and values beyond U+10FFFF) decodes as one
+// REPLACEMENT_CHARACTER per byte, so decoding never reads past the end of the text.
+class utf8_iterator
+{
+    const char*   d_current = nullptr;
+    const char*   d_end = nullptr;
+    std::uint32_t d_codepoint = 0;
+    std::size_t   d_length = 0; // Bytes in the current sequence, zero at the end
+
+    constexpr void decode()
+    {
+        if (d_current == d_end) {
+            d_codepoint = 0;
+            d_length = 0;
+            return;
+        }
+
+        const auto lead = static_cast<unsigned char>(*d_current);
+        if (lead < 0x80) {
+            d_codepoint = lead;
+            d_length = 1;
+            return;
+        }
+
+        std::size_t length = 0;
+        std::uint32_t codepoint = 0;
+        std::uint32_t smallest = 0; // Anything less should have used a shorter sequence
+        if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            codepoint = lead & 0x1F;
+            smallest = 0x80;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            codepoint = lead & 0x0F;
+            smallest = 0x800;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            codepoint = lead & 0x07;
+            smallest = 0x10000;
+        }
+
+        bool valid = length > 0 && (std::size_t)(d_end - d_current) >= length;
+        for (std::size_t i = 1; valid && i != length; ++i) {
+            const auto byte = static_cast<unsigned char>(d_current[i]);
+            valid = (byte & 0xC0) == 0x80;
+            codepoint = (codepoint << 6) | (byte & 0x3F);
+        }
+        valid = valid && codepoint >= smallest && codepoint <= 0x10FFFF
+                      && (codepoint < 0xD800 || codepoint > 0xDFFF);
+
+        d_codepoint = valid ? codepoint : REPLACEMENT_CHARACTER;
+        d_length = valid ? length : 1;
+    }
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = std::uint32_t;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const std::uint32_t*;
+    using reference         = std::uint32_t;
+
+    constexpr utf8_iterator() = default;
+    constexpr utf8_iterator(const char* current, const char* end)
+        : d_current(current)
+        , d_end(end)
+    {
+        decode();
+    }
+
+    constexpr std::uint32_t operator*() const { return d_codepoint; }
+
+    constexpr utf8_iterator& operator++()
+    {
+        d_current += d_length;
+        decode();
+        return *this;
+    }
+
+    constexpr utf8_iterator operator++(int)
+    {
+        auto copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    constexpr bool operator==(const utf8_iterator& other) const { return d_current == other.d_current; }
+
+    // The bytes of the current codepoint.
+    constexpr std::string_view sequence() const { return {d_current, d_length}; }
+};
+
+// The codepoints of UTF-8 text, for use in range-for loops.
+class utf8_view
+{
+    std::string_view d_text;
+
+public:
+    constexpr explicit utf8_view(std::string_view text) : d_text(text) {}
+
+    constexpr utf8_iterator begin() const { return {d_text.data(), d_text.data() + d_text.size()}; }
+    constexpr utf8_iterator end() const { return {d_text.data() + d_text.size(), d_text.data() + d_text.size()}; }
+};
+
+// Appends the UTF-8 encoding of the codepoint, or of REPLACEMENT_CHARACTER if it is not a
+// valid codepoint.
+constexpr void append_utf8(std::string& text, std::uint32_t codepoint)
+{
+    if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        codepoint = REPLACEMENT_CHARACTER;
+    }
+
+    if (codepoint < 0x80) {
+        text.push_back(static_cast<char>(codepoint));
+    } else if (codepoint < 0x800) {
+        text.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        text.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else if (codepoint < 0x10000) {
+        text.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        text.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        text.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    } else {
+        text.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        text.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        text.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        text.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+// Removes the last codepoint, along with all of its bytes.
+constexpr void pop_back_utf8(std::string& text)
+{
+    while (!text.empty() && (static_cast<unsigned char>(text.back()) & 0xC0) == 0x80) {
+        text.pop_back();
+    }
+    if (!text.empty()) {
+        text.pop_back();
+    }
+}
+
+}
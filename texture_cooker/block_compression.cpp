@@ -0,0 +1,225 @@
+#include "block_compression.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace cooker {
+namespace {
+
+using block = std::array<std::array<std::uint8_t, 4>, 16>; // 4x4 RGBA texels
+
+block read_block(std::span<const std::uint8_t> rgba, int width, int height, int bx, int by)
+{
+    block out;
+    for (int y = 0; y != 4; ++y) {
+        for (int x = 0; x != 4; ++x) {
+            const int px = std::min(bx * 4 + x, width - 1);
+            const int py = std::min(by * 4 + y, height - 1);
+            const std::size_t offset = 4 * ((std::size_t)py * width + px);
+            for (int c = 0; c != 4; ++c) {
+                out[y * 4 + x][c] = rgba[offset + c];
+            }
+        }
+    }
+    return out;
+}
+
+void write_u16(std::vector<std::uint8_t>& out, std::uint16_t value)
+{
+    out.push_back((std::uint8_t)(value & 0xff));
+    out.push_back((std::uint8_t)(value >> 8));
+}
+
+void write_u32(std::vector<std::uint8_t>& out, std::uint32_t value)
+{
+    for (int i = 0; i != 4; ++i) {
+        out.push_back((std::uint8_t)(value >> (8 * i)));
+    }
+}
+
+std::uint16_t to_565(const std::array<float, 3>& c)
+{
+    const auto quantise = [](float v, int max) {
+        return (std::uint16_t)std::clamp((int)std::lround(v / 255.0f * max), 0, max);
+    };
+    return (std::uint16_t)((quantise(c[0], 31) << 11) | (quantise(c[1], 63) << 5) | quantise(c[2], 31));
+}
+
+std::array<float, 3> from_565(std::uint16_t c)
+{
+    const int r = (c >> 11) & 31;
+    const int g = (c >> 5) & 63;
+    const int b = c & 31;
+    return {(float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2))};
+}
+
+float distance_squared(const std::array<float, 3>& a, const std::array<std::uint8_t, 4>& b)
+{
+    float d = 0.0f;
+    for (int c = 0; c != 3; ++c) {
+        const float diff = a[c] - (float)b[c];
+        d += diff * diff;
+    }
+    return d;
+}
+
+// Picks the two texels furthest apart along the principal axis of the block's colours.
+std::pair<std::array<float, 3>, std::array<float, 3>> colour_endpoints(const block& texels)
+{
+    std::array<float, 3> mean = {0.0f, 0.0f, 0.0f};
+    for (const auto& t : texels) {
+        for (int c = 0; c != 3; ++c) { mean[c] += t[c] / 16.0f; }
+    }
+
+    std::array<std::array<float, 3>, 3> cov = {};
+    for (const auto& t : texels) {
+        const std::array<float, 3> d = {t[0] - mean[0], t[1] - mean[1], t[2] - mean[2]};
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) { cov[i][j] += d[i] * d[j]; }
+        }
+    }
+
+    // A few rounds of power iteration are plenty to find the dominant axis.
+    std::array<float, 3> axis = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration != 8; ++iteration) {
+        std::array<float, 3> next = {0.0f, 0.0f, 0.0f};
+        for (int i = 0; i != 3; ++i) {
+            for (int j = 0; j != 3; ++j) { next[i] += cov[i][j] * axis[j]; }
+        }
+        const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) { break; }
+        for (int i = 0; i != 3; ++i) { axis[i] = next[i] / length; }
+    }
+
+    float min_proj = INFINITY;
+    float max_proj = -INFINITY;
+    std::array<float, 3> min_colour = mean;
+    std::array<float, 3> max_colour = mean;
+    for (const auto& t : texels) {
+        const float proj = t[0] * axis[0] + t[1] * axis[1] + t[2] * axis[2];
+        if (proj < min_proj) { min_proj = proj; min_colour = {(float)t[0], (float)t[1], (float)t[2]}; }
+        if (proj > max_proj) { max_proj = proj; max_colour = {(float)t[0], (float)t[1], (float)t[2]}; }
+    }
+    return {max_colour, min_colour};
+}
+
+// Appends an 8 byte colour block in four colour mode.
+void encode_colour_block(const block& texels, std::vector<std::uint8_t>& out)
+{
+    const auto [a, b] = colour_endpoints(texels);
+    std::uint16_t c0 = to_565(a);
+    std::uint16_t c1 = to_565(b);
+
+    // Four colour mode requires c0 > c1; if they are equal every texel uses c0.
+    if (c0 < c1) { std::swap(c0, c1); }
+    if (c0 == c1) {
+        write_u16(out, c0);
+        write_u16(out, c1);
+        write_u32(out, 0);
+        return;
+    }
+
+    const auto p0 = from_565(c0);
+    const auto p1 = from_565(c1);
+    std::array<std::array<float, 3>, 4> palette = {p0, p1, p0, p0};
+    for (int c = 0; c != 3; ++c) {
+        palette[2][c] = (2.0f * p0[c] + p1[c]) / 3.0f;
+        palette[3][c] = (p0[c] + 2.0f * p1[c]) / 3.0f;
+    }
+
+    std::uint32_t indices = 0;
+    for (int i = 0; i != 16; ++i) {
+        std::uint32_t best = 0;
+        float best_distance = INFINITY;
+        for (std::uint32_t p = 0; p != 4; ++p) {
+            const float d = distance_squared(palette[p], texels[i]);
+            if (d < best_distance) { best_distance = d; best = p; }
+        }
+        indices |= best << (2 * i);
+    }
+
+    write_u16(out, c0);
+    write_u16(out, c1);
+    write_u32(out, indices);
+}
+
+// Appends an 8 byte single channel block, as used for BC3 alpha and both BC5 channels.
+void encode_channel_block(const block& texels, int channel, std::vector<std::uint8_t>& out)
+{
+    int a0 = 0;
+    int a1 = 255;
+    for (const auto& t : texels) {
+        a0 = std::max(a0, (int)t[channel]);
+        a1 = std::min(a1, (int)t[channel]);
+    }
+
+    out.push_back((std::uint8_t)a0);
+    out.push_back((std::uint8_t)a1);
+
+    // With a0 > a1 there are six interpolated values between the endpoints. If they are
+    // equal every texel uses a0.
+    std::array<int, 8> palette = {a0, a1, 0, 0, 0, 0, 0, 0};
+    for (int i = 1; i != 7; ++i) {
+        palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+    }
+
+    std::uint64_t indices = 0;
+    if (a0 > a1) {
+        for (int i = 0; i != 16; ++i) {
+            std::uint64_t best = 0;
+            int best_distance = 256;
+            for (std::uint64_t p = 0; p != 8; ++p) {
+                const int d = std::abs(palette[p] - (int)texels[i][channel]);
+                if (d < best_distance) { best_distance = d; best = p; }
+            }
+            indices |= best << (3 * i);
+        }
+    }
+    for (int i = 0; i != 6; ++i) {
+        out.push_back((std::uint8_t)(indices >> (8 * i)));
+    }
+}
+
+template <typename Encoder>
+std::vector<std::uint8_t> encode(
+    std::span<const std::uint8_t> rgba, int width, int height, std::size_t block_bytes, Encoder&& encoder)
+{
+    const int blocks_x = (width + 3) / 4;
+    const int blocks_y = (height + 3) / 4;
+    std::vector<std::uint8_t> out;
+    out.reserve((std::size_t)blocks_x * blocks_y * block_bytes);
+    for (int by = 0; by != blocks_y; ++by) {
+        for (int bx = 0; bx != blocks_x; ++bx) {
+            encoder(read_block(rgba, width, height, bx, by), out);
+        }
+    }
+    return out;
+}
+
+}
+
+std::vector<std::uint8_t> encode_bc1(std::span<const std::uint8_t> rgba, int width, int height)
+{
+    return encode(rgba, width, height, 8, [](const block& texels, auto& out) {
+        encode_colour_block(texels, out);
+    });
+}
+
+std::vector<std::uint8_t> encode_bc3(std::span<const std::uint8_t> rgba, int width, int height)
+{
+    return encode(rgba, width, height, 16, [](const block& texels, auto& out) {
+        encode_channel_block(texels, 3, out);
+        encode_colour_block(texels, out);
+    });
+}
+
+std::vector<std::uint8_t> encode_bc5(std::span<const std::uint8_t> rgba, int width, int height)
+{
+    return encode(rgba, width, height, 16, [](const block& texels, auto& out) {
+        encode_channel_block(texels, 0, out);
+        encode_channel_block(texels, 1, out);
+    });
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace cooker {
+
+// CPU encoders for the block compressed formats supported by spkt::texture. Each takes
+// tightly packed RGBA8 pixels and returns the blocks in row-major order. Images whose
+// sizes are not multiples of 4 have their edge pixels repeated to fill the last blocks.
+//
+// The encoders favour simplicity over quality: colour endpoints are the extremes of the
+// block along its principal axis and each texel takes the nearest palette entry.
+
+// RGB, alpha is ignored. 8 bytes per block.
+std::vector<std::uint8_t> encode_bc1(std::span<const std::uint8_t> rgba, int width, int height);
+
+// RGBA. 16 bytes per block.
+std::vector<std::uint8_t> encode_bc3(std::span<const std::uint8_t> rgba, int width, int height);
+
+// The red and green channels only, for normal maps. 16 bytes per block.
+std::vector<std::uint8_t> encode_bc5(std::span<const std::uint8_t> rgba, int width, int height);
+
+}
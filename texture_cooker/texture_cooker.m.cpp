@@ -0,0 +1,239 @@
+// Converts an image into a .dds file with a full mip chain, optionally block compressed,
+// for loading with spkt::texture. Reports the GPU memory of the texture as it would be
+// loaded from the source image and from the cooked file.
+//
+// Usage: texture_cooker <input> <output.dds> [rgba|bc1|bc3|bc5]
+//        texture_cooker --cube <+x> <-x> <+y> <-y> <+z> <-z> <output.dds> [rgba|bc1|bc3|bc5]
+//
+// The second form cooks six square images into a single cube map for spkt::cube_map.
+//
+// bc1 suits opaque colour maps and single channel maps, bc3 colour maps with alpha and bc5
+// normal maps. If no format is given, bc3 is used for images with transparency and bc1
+// otherwise.
+#include "block_compression.h"
+
+#include <sprocket/graphics/dds.h>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct image
+{
+    int width;
+    int height;
+    std::vector<std::uint8_t> rgba;
+};
+
+std::optional<image> load_image(const std::string& file)
+{
+    image img;
+    unsigned char* pixels = stbi_load(file.c_str(), &img.width, &img.height, nullptr, 4);
+    if (!pixels) {
+        std::cerr << std::format("could not load '{}': {}\n", file, stbi_failure_reason());
+        return std::nullopt;
+    }
+    img.rgba.assign(pixels, pixels + 4 * (std::size_t)img.width * img.height);
+    stbi_image_free(pixels);
+    return img;
+}
+
+std::optional<spkt::texture_format> parse_format(std::string_view name)
+{
+    if (name == "rgba") { return spkt::texture_format::RGBA8; }
+    if (name == "bc1") { return spkt::texture_format::BC1; }
+    if (name == "bc3") { return spkt::texture_format::BC3; }
+    if (name == "bc5") { return spkt::texture_format::BC5; }
+    return std::nullopt;
+}
+
+bool has_transparency(const image& img)
+{
+    for (std::size_t i = 3; i < img.rgba.size(); i += 4) {
+        if (img.rgba[i] != 255) { return true; }
+    }
+    return false;
+}
+
+// Halves the image with a box filter. Odd dimensions reuse the last row or column.
+image downsample(const image& src)
+{
+    image dst;
+    dst.width = std::max(src.width / 2, 1);
+    dst.height = std::max(src.height / 2, 1);
+    dst.rgba.resize(4 * (std::size_t)dst.width * dst.height);
+
+    const auto texel = [&](int x, int y, int c) {
+        x = std::min(x, src.width - 1);
+        y = std::min(y, src.height - 1);
+        return (int)src.rgba[4 * ((std::size_t)y * src.width + x) + c];
+    };
+
+    for (int y = 0; y != dst.height; ++y) {
+        for (int x = 0; x != dst.width; ++x) {
+            for (int c = 0; c != 4; ++c) {
+                const int sum = texel(2 * x, 2 * y, c) + texel(2 * x + 1, 2 * y, c)
+                              + texel(2 * x, 2 * y + 1, c) + texel(2 * x + 1, 2 * y + 1, c);
+                dst.rgba[4 * ((std::size_t)y * dst.width + x) + c] = (std::uint8_t)((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+std::vector<std::uint8_t> encode(const image& img, spkt::texture_format format)
+{
+    switch (format) {
+        case spkt::texture_format::BC1: return cooker::encode_bc1(img.rgba, img.width, img.height);
+        case spkt::texture_format::BC3: return cooker::encode_bc3(img.rgba, img.width, img.height);
+        case spkt::texture_format::BC5: return cooker::encode_bc5(img.rgba, img.width, img.height);
+        default: return img.rgba;
+    }
+}
+
+spkt::dds::header make_header(int width, int height, int mip_count, spkt::texture_format format, bool cube_map)
+{
+    namespace dds = spkt::dds;
+    dds::header header = {};
+    header.size = sizeof(dds::header);
+    header.flags = dds::DDSD_CAPS | dds::DDSD_HEIGHT | dds::DDSD_WIDTH | dds::DDSD_PIXELFORMAT | dds::DDSD_MIPMAPCOUNT;
+    header.width = (std::uint32_t)width;
+    header.height = (std::uint32_t)height;
+    header.mip_map_count = (std::uint32_t)mip_count;
+    header.caps = dds::DDSCAPS_TEXTURE | dds::DDSCAPS_COMPLEX | dds::DDSCAPS_MIPMAP;
+    header.format.size = sizeof(dds::pixel_format);
+    if (cube_map) {
+        header.caps2 = dds::DDSCAPS2_CUBEMAP | dds::DDSCAPS2_CUBEMAP_ALLFACES;
+    }
+
+    if (spkt::is_compressed(format)) {
+        header.flags |= dds::DDSD_LINEARSIZE;
+        header.pitch_or_linear_size = (std::uint32_t)spkt::mip_size(format, width, height);
+        header.format.flags = dds::DDPF_FOURCC;
+        switch (format) {
+            case spkt::texture_format::BC1: header.format.four_cc = dds::FOURCC_DXT1; break;
+            case spkt::texture_format::BC3: header.format.four_cc = dds::FOURCC_DXT5; break;
+            default: header.format.four_cc = dds::FOURCC_ATI2; break;
+        }
+    } else {
+        header.flags |= dds::DDSD_PITCH;
+        header.pitch_or_linear_size = (std::uint32_t)(4 * width);
+        header.format.flags = dds::DDPF_RGB | dds::DDPF_ALPHAPIXELS;
+        header.format.rgb_bit_count = 32;
+        header.format.r_mask = 0x000000ff;
+        header.format.g_mask = 0x0000ff00;
+        header.format.b_mask = 0x00ff0000;
+        header.format.a_mask = 0xff000000;
+    }
+    return header;
+}
+
+struct cooked_size
+{
+    std::size_t uncompressed_bytes = 0;
+    std::size_t cooked_bytes = 0;
+};
+
+// Writes the image and its mip chain, largest first.
+cooked_size write_levels(std::ofstream& stream, const image& img, int mip_count, spkt::texture_format format)
+{
+    cooked_size size;
+    image level = img;
+    for (int i = 0; i != mip_count; ++i) {
+        if (i > 0) {
+            level = downsample(level);
+        }
+        const auto bytes = encode(level, format);
+        stream.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        size.uncompressed_bytes += spkt::mip_size(spkt::texture_format::RGBA8, level.width, level.height);
+        size.cooked_bytes += bytes.size();
+    }
+    return size;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const bool cube_map = argc > 1 && std::string_view(argv[1]) == "--cube";
+    const int input_count = cube_map ? 6 : 1;
+    const int first_input = cube_map ? 2 : 1;
+    if (argc < first_input + input_count + 1) {
+        std::cout << std::format("usage: {} <input> <output.dds> [rgba|bc1|bc3|bc5]\n", argv[0]);
+        std::cout << std::format("       {} --cube <+x> <-x> <+y> <-y> <+z> <-z> <output.dds> [rgba|bc1|bc3|bc5]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<image> faces;
+    for (int i = 0; i != input_count; ++i) {
+        auto img = load_image(argv[first_input + i]);
+        if (!img) {
+            return 1;
+        }
+        faces.push_back(std::move(*img));
+    }
+    const std::string input = argv[first_input];
+    const std::string output = argv[first_input + input_count];
+    const image& img = faces.front();
+
+    if (cube_map) {
+        for (int i = 0; i != input_count; ++i) {
+            if (faces[i].width != img.width || faces[i].height != img.height || img.width != img.height) {
+                std::cerr << std::format("cube map faces must be square and the same size, '{}' is not\n", argv[first_input + i]);
+                return 1;
+            }
+        }
+    }
+
+    std::optional<spkt::texture_format> format;
+    if (argc > first_input + input_count + 1) {
+        format = parse_format(argv[first_input + input_count + 1]);
+        if (!format) {
+            std::cerr << std::format("unknown format '{}'\n", argv[first_input + input_count + 1]);
+            return 1;
+        }
+    } else {
+        format = std::ranges::any_of(faces, has_transparency) ? spkt::texture_format::BC3 : spkt::texture_format::BC1;
+    }
+
+    const int mip_count = spkt::full_mip_count(img.width, img.height);
+    const auto header = make_header(img.width, img.height, mip_count, *format, cube_map);
+
+    std::ofstream stream(output, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(&spkt::dds::MAGIC), sizeof(spkt::dds::MAGIC));
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Cube maps store each face in turn, each with its own mip chain.
+    std::size_t uncompressed_bytes = 0;
+    std::size_t cooked_bytes = 0;
+    for (const auto& face : faces) {
+        const auto size = write_levels(stream, face, mip_count, *format);
+        uncompressed_bytes += size.uncompressed_bytes;
+        cooked_bytes += size.cooked_bytes;
+    }
+
+    if (!stream) {
+        std::cerr << std::format("could not write '{}'\n", output);
+        return 1;
+    }
+
+    std::cout << std::format(
+        "{} -> {}: {}x{}{}, {} mips, GPU memory {:.2f} MiB -> {:.2f} MiB\n",
+        input, output, img.width, img.height, cube_map ? " cube map" : "", mip_count,
+        uncompressed_bytes / (1024.0 * 1024.0), cooked_bytes / (1024.0 * 1024.0)
+    );
+    return 0;
+}